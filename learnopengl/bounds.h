@@ -0,0 +1,32 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <limits>
+
+struct Vertex;
+
+// axis aligned bounding box plus a bounding sphere around its center. A default constructed
+// Bounds is empty: merging anything into it gives the other bounds.
+struct Bounds {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    bool isEmpty() const { return min.x > max.x; }
+
+    // grows the bounds to contain other as well
+    void merge(const Bounds &other);
+    // bounds of the box and sphere transformed by matrix (an affine transform). The box is the
+    // tightest one around the transformed box (Arvo 1990), the sphere is scaled by the largest
+    // stretch of matrix.
+    Bounds transformed(const glm::mat4 &matrix) const;
+};
+
+// tight bounding box of the vertex positions and the smallest sphere around the box center that
+// contains them
+Bounds computeBounds(const Vertex *vertices, size_t num_vertices);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <learnopengl/bounds.h>
+#include <learnopengl/cull.h>
+#include <learnopengl/frustum.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// bounding volume hierarchy over the world space bounds of many objects. A frustum query walks
+// the tree and returns the leaves it intersects as ranges of leafBounds(), which cullBounds then
+// tests object by object, so culling costs about the number of visible objects, not all of them.
+// The same tree serves any number of views (camera, shadow maps, reflections).
+class Bvh {
+   public:
+    // leaves hold at most this many objects, one AVX group of cullBounds
+    static constexpr uint32_t MAX_LEAF_SIZE = 8;
+    // subtrees with more objects build their two children in parallel on ThreadPool::global()
+    static constexpr uint32_t PARALLEL_BUILD_SIZE = 4096;
+    // the tree is at most this deep: nodes below half of it are split at their median, which
+    // halves the objects with every level, so query walks the tree with a fixed size stack
+    static constexpr uint32_t MAX_DEPTH = 64;
+
+    // builds the tree over bounds, object i having bounds[i]. The nodes are split with the binned
+    // surface area heuristic (Wald 2007).
+    void build(const std::vector<Bounds> &bounds);
+    // gives object new bounds and refits the boxes of its leaf and of the ancestors that grew or
+    // shrank with it. The tree isn't restructured, so it gets looser the further objects move
+    // from where they were at build time; build again once queries slow down.
+    void update(uint32_t object, const Bounds &bounds);
+    // appends the ranges of leafBounds() whose leaves intersect frustum, in increasing order. A
+    // subtree entirely inside the frustum adds one range without testing the nodes below it.
+    // Returns the number of nodes tested.
+    size_t query(const Frustum &frustum, std::vector<BoundsRange> &ranges) const;
+
+    // the bounds of the objects in leaf order, the order of the ranges query returns
+    const BoundsList &leafBounds() const { return leaf_bounds; }
+    // the object at position i of leafBounds()
+    uint32_t object(size_t i) const { return leaf_objects[i]; }
+    size_t size() const { return leaf_objects.size(); }
+
+   private:
+    struct Node {
+        glm::vec3 min = glm::vec3(0.0f);
+        // the objects of the subtree are [first, first + count) in leaf order
+        uint32_t first = 0;
+        glm::vec3 max = glm::vec3(0.0f);
+        uint32_t count = 0;
+        // the two children are child and child + 1, 0 for a leaf (the root is never a child)
+        uint32_t child = 0;
+        uint32_t parent = 0;
+    };
+
+    // an object as build sorts it, kept apart from object_bounds so splitting a node reads and
+    // writes one contiguous range
+    struct BuildItem;
+
+    void buildNode(BuildItem *items, uint32_t node, uint32_t depth, uint32_t first,
+                   uint32_t count, std::atomic<uint32_t> &num_nodes);
+    // sets the box of node to the one around its objects (leaf) or children, returns whether it
+    // changed
+    bool refitNode(uint32_t node);
+
+    std::vector<Node> nodes;
+    // bounds of every object, in the order they were given to build
+    std::vector<Bounds> object_bounds;
+    // object of every position in leaf order and the other way round
+    std::vector<uint32_t> leaf_objects;
+    std::vector<uint32_t> object_positions;
+    // leaf node of every position in leaf order
+    std::vector<uint32_t> position_leaves;
+    BoundsList leaf_bounds;
+};
+
+#endif
\ No newline at end of file
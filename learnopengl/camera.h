@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include <glad/glad.h>
+#include <learnopengl/frustum.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -67,6 +68,11 @@ class Camera {
     // returns the view matrix calculated using Euler Angles and the LookAt Matrix
     glm::mat4 GetViewMatrix() { return glm::lookAt(Position, Position + Front, Up); }
 
+    // returns the world space planes of the view frustum of the camera seen through projection
+    Frustum GetFrustum(const glm::mat4 &projection) {
+        return Frustum(projection * GetViewMatrix());
+    }
+
     // processes input received from any keyboard-like input system. Accepts input parameter in the
     // form of camera defined ENUM (to abstract it from windowing systems)
     virtual void ProcessKeyboard(Camera_Movement direction, float deltaTime) {
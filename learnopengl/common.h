@@ -2,6 +2,7 @@
 #define COMMON_H_
 
 #include <learnopengl/camera.h>
+#include <learnopengl/gl_state.h>
 #include <learnopengl/model.h>
 #include <learnopengl/shader.h>
 #include <learnopengl/texture.h>
@@ -0,0 +1,72 @@
+#ifndef CULL_H
+#define CULL_H
+
+#include <learnopengl/bounds.h>
+#include <learnopengl/frustum.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// world space bounds of many objects, stored as one array per component so cullBounds can test
+// several objects with each SIMD instruction
+struct BoundsList {
+    // center and half extent of the boxes
+    std::vector<float> center_x, center_y, center_z;
+    std::vector<float> extent_x, extent_y, extent_z;
+    // bounding sphere radius, for the projected size
+    std::vector<float> radius;
+
+    size_t size() const { return radius.size(); }
+    void clear();
+    void add(const Bounds &bounds);
+    // replaces the bounds of object i
+    void set(size_t i, const Bounds &bounds);
+};
+
+// objects [first, first + count) of a BoundsList
+struct BoundsRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// what cullBounds did with the objects it was given
+struct CullStats {
+    // objects whose bounds were tested one by one
+    size_t tested = 0;
+    // outside of the frustum, including the ones culled with a Bvh node without being tested
+    size_t outside = 0;
+    // in the frustum, but projected to fewer than min_pixels
+    size_t too_small = 0;
+    // Bvh nodes tested
+    size_t nodes = 0;
+
+    size_t culled() const { return outside + too_small; }
+    CullStats &operator+=(const CullStats &other) {
+        tested += other.tested;
+        nodes += other.nodes;
+        outside += other.outside;
+        too_small += other.too_small;
+        return *this;
+    }
+};
+
+// appends the indices of the objects in bounds that intersect frustum and whose bounding sphere
+// projects to at least min_pixels across to visible, in increasing order. projection_scale is
+// the number of pixels a world unit covers at distance 1 from camera_pos (viewport height / 2
+// tan(fov_y / 2)); a min_pixels of 0 disables the size test. Empty bounds are always culled.
+//
+// Tests 8 objects per iteration with AVX (when compiled with it) and 4 with SSE, with the boxes
+// tested against every plane (not just the spheres), so fewer objects pass than with
+// Frustum::intersectsSphere.
+CullStats cullBounds(const Frustum &frustum, const BoundsList &bounds,
+                     const glm::vec3 &camera_pos, float projection_scale, float min_pixels,
+                     std::vector<uint32_t> &visible);
+// same as above for the objects of ranges only, such as the leaves a Bvh query returned, in the
+// order of ranges. Ranges as short as the leaves are still tested a full SIMD group at a time.
+CullStats cullBounds(const Frustum &frustum, const BoundsList &bounds,
+                     const std::vector<BoundsRange> &ranges, const glm::vec3 &camera_pos,
+                     float projection_scale, float min_pixels, std::vector<uint32_t> &visible);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// view frustum as six planes (left, right, bottom, top, near, far) pointing inwards, extracted
+// from a projection * view (* model) matrix (Gribb & Hartmann). The planes live in the space the
+// matrix maps from, so passing projection * view * model gives planes in model space.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    Frustum() = default;
+    explicit Frustum(const glm::mat4 &matrix) {
+        glm::vec4 row_x(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+        glm::vec4 row_y(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+        glm::vec4 row_z(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+        glm::vec4 row_w(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+        planes[0] = row_w + row_x;
+        planes[1] = row_w - row_x;
+        planes[2] = row_w + row_y;
+        planes[3] = row_w - row_y;
+        planes[4] = row_w + row_z;
+        planes[5] = row_w - row_z;
+        for (auto &plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    // false if the sphere is completely outside of the frustum
+    bool intersectsSphere(const glm::vec3 &center, float radius) const {
+        for (const auto &plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+        }
+        return true;
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef GEOMETRY_BUFFER_H
+#define GEOMETRY_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+
+// how the vertices of a layout are fed to the vertex shader
+struct VertexLayout {
+    // meshes with the same id share a vertex buffer and a VAO
+    unsigned int id = 0;
+    // bytes per vertex
+    size_t stride = 0;
+    // sets the attribute pointers of the bound VAO for the vertices in the bound GL_ARRAY_BUFFER
+    void (*setAttributes)() = nullptr;
+};
+
+// vertex and index storage shared by many meshes, e.g. all meshes of a model or of a whole scene.
+// The meshes are sub-allocated from one vertex buffer per vertex layout and one index buffer
+// next to it, so all meshes with the same layout share a VAO and are drawn with
+// glDrawElementsBaseVertex at their offsets instead of binding a VAO per mesh.
+//
+// Allocations are never freed on their own, the buffers grow (copying their contents on the GPU)
+// when they run full. Like the textures in TextureCache the GL objects aren't deleted by the
+// destructor, which may run without a current context, but by release(). Must be used on the GL
+// thread.
+class GeometryBuffer {
+   public:
+    // where a mesh was placed
+    struct Range {
+        // VAO of the layout, with the vertex and index buffer attached
+        unsigned int vao = 0;
+        // index of the first vertex, added to every index by the draw
+        GLint base_vertex = 0;
+        // byte offset of the first index in the index buffer
+        size_t index_offset = 0;
+    };
+
+    GeometryBuffer() = default;
+    GeometryBuffer(const GeometryBuffer &) = delete;
+    GeometryBuffer &operator=(const GeometryBuffer &) = delete;
+
+    // makes room for num_vertices more vertices and index_bytes more index data in the buffers
+    // of layout, so a batch of allocations grows each buffer at most once
+    void reserve(const VertexLayout &layout, size_t num_vertices, size_t index_bytes);
+    // copies num_vertices vertices of layout and index_bytes of index data into the buffers.
+    // Indices are relative to the first vertex of the mesh, they may be 16 or 32 bit.
+    Range allocate(const VertexLayout &layout, const void *vertex_data, size_t num_vertices,
+                   const void *index_data, size_t index_bytes);
+
+    // bytes of vertex and index data stored / allocated on the GPU
+    size_t usedBytes() const;
+    size_t capacityBytes() const;
+
+    // deletes the buffers and VAOs, once no mesh allocated from them is drawn anymore. The
+    // buffer is empty afterwards and may be allocated from again.
+    void release();
+
+    // index allocations start at multiples of this, so 16 and 32 bit indices can share a buffer
+    static constexpr size_t INDEX_ALIGNMENT = 4;
+
+   private:
+    // the buffers of one vertex layout
+    struct Arena {
+        VertexLayout layout;
+        unsigned int vao = 0;
+        unsigned int vbo = 0;
+        unsigned int ebo = 0;
+        size_t vertex_used = 0;
+        size_t vertex_capacity = 0;
+        size_t index_used = 0;
+        size_t index_capacity = 0;
+    };
+
+    Arena &arena(const VertexLayout &layout);
+    // grows the buffers of arena to hold at least vertex_bytes and index_bytes
+    void grow(Arena &arena, size_t vertex_bytes, size_t index_bytes);
+
+    std::map<unsigned int, Arena> arenas;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+// fixed function state blocks, the defaults are the ones of a new context
+struct DepthState {
+    bool test = false;
+    bool write = true;
+    GLenum func = GL_LESS;
+};
+
+struct BlendState {
+    bool enabled = false;
+    GLenum src = GL_ONE;
+    GLenum dst = GL_ZERO;
+};
+
+struct CullState {
+    bool enabled = false;
+    GLenum face = GL_BACK;
+};
+
+struct StencilState {
+    bool test = false;
+    GLenum func = GL_ALWAYS;
+    GLint ref = 0;
+    GLuint read_mask = ~0u;
+    GLuint write_mask = ~0u;
+    GLenum stencil_fail = GL_KEEP;
+    GLenum depth_fail = GL_KEEP;
+    GLenum depth_pass = GL_KEEP;
+};
+
+// shadow copy of the bindings and fixed function state of the context. Every call compares
+// against the copy and only reaches the driver if it changes something, so draws can bind
+// everything they need without first checking what the previous draw left behind.
+//
+// The copy is only right as long as all changes go through it. Code calling the GL functions
+// directly in between has to call invalidate() afterwards, which makes the next call of every
+// kind reach the driver again. Deleting a bound object unbinds it, so textures, buffers and VAOs
+// that may be bound are deleted with deleteTextures / deleteBuffers / deleteVertexArrays. Must be
+// used on the GL thread.
+class GLState {
+   public:
+    // number of GL calls made and skipped because they wouldn't have changed anything
+    struct Stats {
+        size_t issued = 0;
+        size_t elided = 0;
+    };
+
+    static GLState &global();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    // binds texture to target of unit, switching the active unit only when needed
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    // binds texture to target of the active unit, e.g. to upload it
+    void bindTexture(GLenum target, GLuint texture);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                         GLsizeiptr size);
+
+    void setDepth(const DepthState &state);
+    void setBlend(const BlendState &state);
+    void setCull(const CullState &state);
+    void setStencil(const StencilState &state);
+
+    void deleteTextures(GLsizei count, const GLuint *ids);
+    void deleteBuffers(GLsizei count, const GLuint *ids);
+    void deleteVertexArrays(GLsizei count, const GLuint *ids);
+    // number of deleteVertexArrays calls so far. Code keeping per VAO state compares it to drop
+    // the state of deleted VAOs, whose names GL may hand out again.
+    size_t vertexArrayDeletions() const { return vertex_array_deletions; }
+
+    // forgets everything, for after GL calls made around the tracker
+    void invalidate();
+
+    const Stats &stats() const { return counters; }
+    void resetStats() { counters = Stats(); }
+
+    // units and uniform buffer binding points above these are bound without tracking
+    static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+    static constexpr GLuint MAX_UNIFORM_BINDINGS = 16;
+
+   private:
+    // value of a binding that isn't known
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    struct BufferRange {
+        GLuint buffer = UNKNOWN;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    GLState() { invalidate(); }
+
+    // counts the call and returns whether it has to be made
+    bool changes(bool differs) {
+        ++(differs ? counters.issued : counters.elided);
+        return differs;
+    }
+    void setCapability(GLenum capability, bool enabled) {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+
+    GLuint program;
+    GLuint vao;
+    GLuint active_unit;
+    // texture bound to each tracked target (see textureTarget in gl_state.cpp) of every unit
+    std::array<std::array<GLuint, 4>, MAX_TEXTURE_UNITS> textures;
+    // buffer bound to each tracked target (see bufferTarget in gl_state.cpp)
+    std::array<GLuint, 4> buffers;
+    std::array<BufferRange, MAX_UNIFORM_BINDINGS> uniform_ranges;
+    std::optional<DepthState> depth;
+    std::optional<BlendState> blend;
+    std::optional<CullState> cull;
+    std::optional<StencilState> stencil;
+    Stats counters;
+    size_t vertex_array_deletions = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef INDIRECT_DRAW_H
+#define INDIRECT_DRAW_H
+
+#include <glad/glad.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+// GL 4.3, not part of the GL 3.3 core profile glad is generated for
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// loads glMultiDrawElementsIndirect if the current context is GL 4.3 or newer. Call after
+// gladLoadGLLoader, with the same loader. Returns whether IndirectDrawList can be used.
+bool loadIndirectDraw(GLADloadproc load);
+bool hasIndirectDraw();
+
+// vertex attribute holding the index of the draw in the IndirectDrawList. Shaders read the
+// model matrix and material of the draw from the samplerBuffer at DRAW_DATA_TEXTURE_UNIT with it.
+constexpr GLuint DRAW_INDEX_ATTRIBUTE = 7;
+
+// a command in GL_DRAW_INDIRECT_BUFFER, as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    // the draw index, read through DRAW_INDEX_ATTRIBUTE with a divisor of 1
+    GLuint base_instance;
+};
+
+// draws of a frame submitted with glMultiDrawElementsIndirect. The model matrix and material
+// constants of every draw go into a texture buffer and the draw commands into an indirect
+// buffer. Draws that follow each other with the same VAO, index type and texture key form a
+// bucket, which is drawn by one call after binding the textures once. Meshes whose textures are
+// layers of the same arrays (see packTextureArrays) share a bucket whatever their materials are.
+// Adding the draws in RenderQueue order keeps the buckets few.
+//
+// The shaders take the model matrix and material from the texture buffer while the
+// use_draw_data uniform is set, see 1.model_loading.vs and .fs. The texture buffer holds as many
+// draws as GL_MAX_TEXTURE_BUFFER_SIZE allows (at least 65536 texels, 8192 draws); longer lists
+// are split into chunks of that many draws, which start new buckets and are uploaded and drawn
+// one after the other. Requires hasIndirectDraw(), must be used on the GL thread. Like the
+// buffers of GeometryBuffer, the GL objects aren't deleted by the destructor.
+class IndirectDrawList {
+   public:
+    // texture unit the draw data is bound to, the draw_data sampler must be set to it
+    static constexpr GLuint DRAW_DATA_TEXTURE_UNIT = 6;
+
+    // removes the draws added since the last clear()
+    void clear();
+    // adds mesh at the given level of detail
+    void add(const Mesh &mesh, size_t lod, const glm::mat4 &model);
+    // adds the ranges of the full detail level of mesh (see Mesh::visibleMeshlets)
+    void add(const Mesh &mesh, const std::vector<IndexRange> &ranges, const glm::mat4 &model);
+    // uploads the draws and issues one glMultiDrawElementsIndirect per bucket
+    void submit(Shader &shader);
+
+    // draws added since the last clear()
+    size_t numDraws() const { return draws.size(); }
+    // glMultiDrawElementsIndirect calls submit() makes for them
+    size_t numCalls() const { return buckets.size(); }
+
+   private:
+    // what the shaders read for a draw, eight RGBA32F texels
+    struct DrawData {
+        glm::mat4 model;
+        // the MaterialBlock of the mesh, with the integers converted to floats:
+        // (color_ambient, shininess), (color_diffuse, dissolve),
+        // (color_specular, use_diffuse_alpha), (diffuse, specular, reflection layer, 0)
+        glm::vec4 material[4];
+    };
+
+    struct Bucket {
+        const Mesh *mesh;
+        size_t first_command;
+        size_t num_commands;
+        // first draw of the chunk the bucket belongs to, its commands count draws from there
+        size_t chunk_first_draw;
+    };
+
+    // draws of a chunk, the ones the texture buffer holds. Queried once.
+    static size_t maxChunkDraws();
+
+    // starts a bucket unless mesh can be drawn with the last one, and a chunk once the current
+    // one is full
+    void addBucket(const Mesh &mesh);
+    void addDraw(const Mesh &mesh, const glm::mat4 &model);
+    void addCommand(const Mesh &mesh, size_t first_index, size_t count);
+
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<DrawData> draws;
+    std::vector<Bucket> buckets;
+    size_t chunk_first_draw = 0;
+    unsigned int command_buffer = 0;
+    unsigned int draw_buffer = 0;
+    unsigned int draw_texture = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file. The mapping is released when the object is destroyed,
+// so pointers into data() must not outlive it.
+class MappedFile {
+   public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool isOpen() const { return mapped != nullptr; }
+    const unsigned char *data() const { return mapped; }
+    size_t size() const { return mapped_size; }
+
+   private:
+    void close();
+
+    const unsigned char *mapped = nullptr;
+    size_t mapped_size = 0;
+};
+
+#endif
\ No newline at end of file
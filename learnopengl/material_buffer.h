@@ -0,0 +1,101 @@
+#ifndef MATERIAL_BUFFER_H
+#define MATERIAL_BUFFER_H
+
+#include <glad/glad.h>
+#include <learnopengl/gl_state.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// uniform buffer binding point of the MaterialBlock uniform block
+constexpr GLuint MATERIAL_BLOCK_BINDING = 0;
+
+// the material constants of a mesh, in the std140 layout of this block:
+//   layout(std140) uniform MaterialBlock {
+//       vec3 color_ambient;
+//       float shininess;
+//       vec3 color_diffuse;
+//       float dissolve;
+//       vec3 color_specular;
+//       bool use_diffuse_alpha;
+//       int diffuse_layer;
+//       int specular_layer;
+//       int reflection_layer;
+//   };
+struct MaterialBlock {
+    glm::vec3 color_ambient = glm::vec3(0.0f);
+    float shininess = 0.0f;
+    glm::vec3 color_diffuse = glm::vec3(0.0f);
+    float dissolve = 1.0f;
+    glm::vec3 color_specular = glm::vec3(0.0f);
+    // a GLSL bool takes 4 bytes
+    int32_t use_diffuse_alpha = 0;
+    // layers of the diffuse, specular and reflection texture in the arrays Mesh::bindMaterial
+    // binds from TEXTURE_ARRAY_UNIT on (see packTextureArrays), -1 where the 2D texture is
+    // sampled instead
+    int32_t diffuse_layer = -1;
+    int32_t specular_layer = -1;
+    int32_t reflection_layer = -1;
+    // std140 rounds the size of the block up to a multiple of 16
+    int32_t padding = 0;
+};
+
+static_assert(sizeof(MaterialBlock) == 64, "MaterialBlock must match the std140 layout");
+
+// process wide uniform buffer holding the MaterialBlock of every mesh, written when the mesh is
+// uploaded. Identical blocks are stored once. A draw binds the range of its mesh with
+// glBindBufferRange instead of setting the material uniforms one by one.
+//
+// All calls must run on the GL thread. The buffer is never shrunk, a block nothing uses any more
+// is overwritten by the next new one; like the textures in TextureCache it lives as long as the
+// context.
+class MaterialBuffer {
+   public:
+    static MaterialBuffer &global();
+
+    // stores block unless an identical one is stored already, returns its byte offset. Every add
+    // is a use of the block.
+    size_t add(const MaterialBlock &block);
+    // replaces one use of the block at offset, returned by add, with block and returns the offset
+    // of block. The block is rewritten in place when nothing else uses it.
+    size_t update(size_t offset, const MaterialBlock &block);
+    // binds the block at offset to MATERIAL_BLOCK_BINDING, meshes sharing a material don't
+    // rebind it
+    void bind(size_t offset) const {
+        GLState::global().bindBufferRange(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, buffer,
+                                          static_cast<GLintptr>(offset), sizeof(MaterialBlock));
+    }
+
+    // number of distinct blocks stored
+    size_t size() const { return offsets.size(); }
+
+   private:
+    static std::string key(const MaterialBlock &block) {
+        return std::string(reinterpret_cast<const char *>(&block), sizeof(block));
+    }
+    // drops one use of the block at offset, a block without uses is forgotten and its slot
+    // reused
+    void release(size_t offset);
+    // writes block to offset of contents and of the buffer
+    void write(size_t offset, const MaterialBlock &block);
+
+    unsigned int buffer = 0;
+    // distance between blocks, sizeof(MaterialBlock) rounded up to
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t stride = 0;
+    size_t capacity = 0;
+    // CPU copy of the buffer, uploaded as a whole when the buffer grows
+    std::vector<unsigned char> contents;
+    // offset by the bytes of the block
+    std::unordered_map<std::string, size_t> offsets;
+    // uses of the block in every slot, by offset / stride
+    std::vector<size_t> uses;
+    // offsets of the slots without uses
+    std::vector<size_t> free_offsets;
+};
+
+#endif
\ No newline at end of file
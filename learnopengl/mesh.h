@@ -1,16 +1,27 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <assimp/material.h>
 #include <glad/glad.h>  // holds all OpenGL type declarations
 
+#include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "bounds.h"
+#include "frustum.h"
+#include "geometry_buffer.h"
+#include "material_buffer.h"
+#include "meshlet.h"
 #include "shader.h"
 #include "texture.h"
+#include "texture_array.h"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -31,6 +42,25 @@ struct Vertex {
     float m_Weights[MAX_BONE_INFLUENCE];
 };
 
+// layout of the vertex buffer a Mesh uploads its vertices in
+enum class VertexFormat {
+    // Vertex as is, 88 bytes per vertex
+    Full,
+    // 24 bytes per vertex: float position, 10-10-10-2 normal and tangent and half float texture
+    // coords. The bitangent is not stored, tangent.w holds its sign so shaders can rebuild it as
+    // cross(normal, tangent.xyz) * tangent.w. Bone ids and weights (12 more bytes) are only
+    // stored for meshes with bones.
+    Packed
+};
+
+// whether a Mesh keeps a CPU copy of its vertices and indices after uploading them
+enum class CpuResidency {
+    // free them once they are uploaded
+    Release,
+    // keep them, e.g. for picking or physics
+    Keep
+};
+
 struct Material {
     std::string name;
     glm::vec3 color_ambient;
@@ -41,39 +71,236 @@ struct Material {
     float refracti = 1.0;
 };
 
-extern std::map<aiTextureType, std::string> ai_texture_type_to_type;
+// a texture referenced by a mesh material, resolved to a loaded Texture when the mesh is uploaded
+struct TextureRef {
+    TextureRole role = TextureRole::Diffuse;
+    std::string path;
+};
+
+// a level of detail of a mesh: a range of its index buffer, drawn with the vertices shared by all
+// levels
+struct MeshLod {
+    size_t index_offset = 0;
+    size_t num_indices = 0;
+    // how far the surface is off the full detail mesh, relative to the mesh extent
+    float error = 0;
+};
+
+// consecutive indices of a mesh, relative to its first index
+struct IndexRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
+// CPU side result of importing a mesh, ready to be uploaded to GL
+struct MeshData {
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<TextureRef> textures;
+    Material material;
+    bool has_bones = false;
+    // the levels of detail in indices, the full mesh first. Empty if there are no coarser LODs.
+    std::vector<MeshLod> lods;
+    // clusters of the full detail level, empty if the mesh isn't split into meshlets
+    std::vector<Meshlet> meshlets;
+    // bounds of the vertices, filled by the import
+    Bounds bounds;
+};
+
+// mesh whose vertex and index arrays are owned elsewhere (a MeshData or a mapped mesh cache)
+struct MeshView {
+    std::string name;
+    Material material;
+    std::vector<TextureRef> textures;
+    const Vertex *vertices = nullptr;
+    size_t num_vertices = 0;
+    const unsigned int *indices = nullptr;
+    size_t num_indices = 0;
+    bool has_bones = false;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    Bounds bounds;
+
+    MeshView() = default;
+    explicit MeshView(const MeshData &data)
+        : name(data.name),
+          material(data.material),
+          textures(data.textures),
+          vertices(data.vertices.data()),
+          num_vertices(data.vertices.size()),
+          indices(data.indices.data()),
+          num_indices(data.indices.size()),
+          has_bones(data.has_bones),
+          lods(data.lods),
+          meshlets(data.meshlets),
+          bounds(data.bounds) {}
+
+    size_t sizeInBytes() const {
+        return num_vertices * sizeof(Vertex) + num_indices * sizeof(unsigned int);
+    }
+};
+
+extern std::map<aiTextureType, TextureRole> ai_texture_type_to_role;
 
 class Mesh {
    public:
-    // constructor
+    // constructor, move the vertices and indices in to avoid copying them. Meshes with at most
+    // 65536 vertices get 16-bit indices in every format. The vertices and indices are uploaded
+    // into geometry_buffer, which the mesh must not outlive, or into buffers of its own if it is
+    // null.
     Mesh(const std::string &name, std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-         std::multimap<std::string, Texture> textures, Material material);
+         std::vector<Texture> textures, Material material,
+         VertexFormat format = VertexFormat::Full, bool has_bones = false,
+         CpuResidency residency = CpuResidency::Release,
+         GeometryBuffer *geometry_buffer = nullptr);
+    // uploads vertex/index data owned by the caller (e.g. a mapped cache file), copying it only
+    // with CpuResidency::Keep. lods splits the indices into levels of detail, without it all
+    // indices form a single level. bounds are the bounds of the vertices if the caller has them
+    // already, they are computed otherwise.
+    Mesh(const std::string &name, const Vertex *vertex_data, size_t num_vertices,
+         const unsigned int *index_data, size_t num_indices,
+         std::vector<Texture> textures, Material material,
+         VertexFormat format = VertexFormat::Full, bool has_bones = false,
+         std::vector<MeshLod> lods = {}, CpuResidency residency = CpuResidency::Release,
+         const Bounds *bounds = nullptr, GeometryBuffer *geometry_buffer = nullptr);
+
+    // render the mesh at the given level of detail. The VAO, textures and material are bound
+    // through GLState and left bound, so meshes drawn in a row only bind what differs. The
+    // samplers of shader must have been set with setSamplerUnits.
+    void Draw(Shader &shader, size_t lod = 0) const;
+    // same as Draw, but expects getVAO() to be bound already
+    void DrawWithBoundVAO(size_t lod = 0) const;
+    // renders the full detail level without the meshlets that are outside of frustum and, with
+    // cull_backfacing, the ones facing away from camera_pos (both in model space). Backface
+    // culling only matches what GL draws with GL_CULL_FACE enabled. Draws the whole mesh if it
+    // has no meshlets. Returns the number of meshlets drawn.
+    size_t DrawMeshlets(const Frustum &frustum, const glm::vec3 &camera_pos,
+                        bool cull_backfacing) const;
+    // appends the index ranges DrawMeshlets would draw to ranges, for callers submitting the
+    // draw themselves. Returns the number of visible meshlets.
+    size_t visibleMeshlets(const Frustum &frustum, const glm::vec3 &camera_pos,
+                           bool cull_backfacing, std::vector<IndexRange> &ranges) const;
+    // binds the textures and the MaterialBlock of the mesh
+    void bindMaterial() const;
+    // binds the textures only. The draws after it may be of any mesh with the same
+    // getTextureKey(), as long as they get their material constants elsewhere.
+    void bindTextures() const;
+    // samples the textures that are in layers (by the id of the 2D texture, see
+    // packTextureArrays) from their arrays instead
+    void setTextureLayers(const std::unordered_map<unsigned int, TextureLayer> &layers);
 
-    // render the mesh
-    void Draw(Shader &shader) const;
+    void setMeshlets(std::vector<Meshlet> meshlets) { this->meshlets = std::move(meshlets); }
+    const std::vector<Meshlet> &getMeshlets() const { return meshlets; }
 
-    unsigned int getVAO() const { return VAO; }
-    const std::vector<unsigned int> &getindices() const { return indices; }
+    // the CPU copies of the vertices and indices, empty unless the mesh was created with
+    // CpuResidency::Keep
+    const std::vector<Vertex> &getVertices() const { return vertices; }
+    const std::vector<unsigned int> &getIndices() const { return indices; }
+    // frees the CPU copies of the vertices and indices
+    void releaseCpuData();
+    // bytes of CPU memory held for the geometry of the mesh
+    size_t residentBytes() const;
+
+    // VAO of the vertex layout in the GeometryBuffer of the mesh, shared with the other meshes
+    // of that layout
+    unsigned int getVAO() const { return geometry.vao; }
+    // the indices of the mesh are relative to this vertex of the VAO
+    GLint getBaseVertex() const { return geometry.base_vertex; }
+    // byte offset of the full detail level in the index buffer of the VAO
+    size_t getIndexOffset() const { return geometry.index_offset; }
+    // number of indices of the full detail level, which starts at getIndexOffset()
+    size_t getNumIndices() const { return lods[0].num_indices; }
+    size_t getNumLods() const { return lods.size(); }
+    const MeshLod &getLod(size_t lod) const { return lods[lod]; }
+    // bounding box and sphere in model space
+    const Bounds &getBounds() const { return bounds; }
+    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, to be passed to glDrawElements* with the VAO
+    GLenum getIndexType() const { return index_type; }
+    VertexFormat getVertexFormat() const { return format; }
 
     bool isTransparent() const { return material.dissolve != 1.0; }
+    // same for meshes binding the same textures, small numbers first. Meshes whose textures are
+    // layers of the same arrays share the key whatever layers they use.
+    uint32_t getTextureKey() const { return texture_key; }
+    // the material constants bindMaterial binds
+    const MaterialBlock &getMaterialBlock() const { return material_block; }
 
-    static std::map<std::string, Texture> dummy_textures;
+    // bound for the roles a mesh has no texture for. Meshes pick them up when they are created,
+    // so they must be loaded before the meshes are.
     static void loadDummyTextures();
+    // the dummy texture of role, its id is 0 if there is none
+    static const Texture &dummyTexture(TextureRole role) {
+        return dummy_textures[static_cast<size_t>(role)];
+    }
+    // texture unit the first texture of role is bound to, and the array it is packed in to
+    // TEXTURE_ARRAY_UNIT plus it. -1 for roles no shader samples, which aren't bound.
+    static int textureUnit(TextureRole role);
+    // points the samplers of the roles at their units, e.g. texture_diffuse1 and
+    // material.texture_diffuse1 at textureUnit(TextureRole::Diffuse). Call once for every
+    // program that draws meshes, while it is in use; draws don't set samplers.
+    static void setSamplerUnits(Shader &shader);
+
+    // layout of the vertex buffer of meshes uploaded in format
+    static VertexLayout vertexLayout(VertexFormat format, bool has_bones);
+    // grows geometry so that meshes, uploaded in format, fit without reallocating its buffers
+    static void reserveGeometry(GeometryBuffer &geometry, const std::vector<MeshView> &meshes,
+                                VertexFormat format);
 
    private:
     // mesh Data
     std::string name;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::multimap<std::string, Texture> textures;
+    std::vector<Texture> textures;
     Material material;
-    unsigned int VAO;
+    size_t num_indices = 0;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    Bounds bounds;
+    VertexFormat format = VertexFormat::Full;
+    bool has_bones = false;
+    GLenum index_type = GL_UNSIGNED_INT;
+
+    // a texture bindTextures binds
+    struct TextureBinding {
+        GLuint unit = 0;
+        GLenum target = GL_TEXTURE_2D;
+        GLuint id = 0;
+    };
+    // one for each role textureUnit() assigns a unit to
+    static constexpr size_t MAX_TEXTURE_BINDINGS = 3;
+    static std::array<Texture, NUM_TEXTURE_ROLES> dummy_textures;
 
     // render data
-    unsigned int VBO, EBO;
+    GeometryBuffer::Range geometry;
+    std::array<TextureBinding, MAX_TEXTURE_BINDINGS> texture_bindings;
+    size_t num_texture_bindings = 0;
+    MaterialBlock material_block;
+    // offset of material_block in MaterialBuffer::global()
+    size_t material_offset = 0;
+    uint32_t texture_key = 0;
+    // the buffers of a mesh created without a GeometryBuffer
+    std::shared_ptr<GeometryBuffer> own_geometry;
+    // the draws of DrawMeshlets, kept to not allocate every frame
+    mutable std::vector<IndexRange> meshlet_ranges;
+    mutable std::vector<GLsizei> meshlet_counts;
+    mutable std::vector<const void *> meshlet_offsets;
+    mutable std::vector<GLint> meshlet_base_vertices;
 
-    // initializes all the buffer objects/arrays
-    void setupMesh();
+    // uploads the vertices and indices into geometry_buffer (or own_geometry if it is null)
+    void setupMesh(const Vertex *vertex_data, size_t num_vertices, const unsigned int *index_data,
+                   GeometryBuffer *geometry_buffer);
+    // resolves the texture bindings, gathers the material constants and layers in material_block
+    // and numbers the set of bound textures
+    void setupMaterial();
+    size_t indexSize() const {
+        return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    }
+    // byte offset of index in the index buffer of the VAO, as glDrawElements* takes it
+    const void *indexPointer(size_t index) const {
+        return (const void *)(geometry.index_offset + index * indexSize());
+    }
 };
 
 Texture TextureFromFile(std::string_view filename, const std::string &directory);
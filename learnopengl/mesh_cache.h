@@ -0,0 +1,55 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// versioned binary cache of the imported meshes of a model, stored next to the model file. The
+// first import writes the final vertex/index arrays together with the material and texture
+// references of each mesh; later runs map the file and hand the buffers straight to GL. The cache
+// is invalidated when the source file or, for OBJ, one of its material libraries (size, mtime or
+// content hash), the import flags, the processing flags, the vertex layout or the format version
+// change. A file that was only touched gets its new mtime written back to the cache.
+//
+// processing_flags describe what the caller did to the meshes after the import (e.g. optimizing
+// them), a cache written with other flags is not used.
+//
+// A partial cache holds only the meshes some loads asked for. The names of the cached meshes are
+// kept in a table of contents, so a subset is found without reading the other mesh records.
+class MeshCache {
+   public:
+    // maps the cache of the model file at source_path. isValid() returns false if there is no
+    // usable cache.
+    MeshCache(const std::string &source_path, unsigned int import_flags,
+              unsigned int processing_flags = 0);
+
+    bool isValid() const { return valid; }
+    // true if the cache doesn't hold every mesh of the source file
+    bool isPartial() const { return partial; }
+    size_t size() const { return mesh_offsets.size(); }
+    const std::string &meshName(size_t i) const { return mesh_names.at(i); }
+    // the vertex and index pointers of the returned view point into the mapped file and are valid
+    // as long as the cache
+    MeshView mesh(size_t i) const;
+
+    // writes the cache for the model file at source_path, returns false on failure. partial
+    // tells that meshes holds only some meshes of the file.
+    static bool write(const std::string &source_path, unsigned int import_flags,
+                      unsigned int processing_flags, const std::vector<MeshData> &meshes,
+                      bool partial = false);
+
+    static std::string cachePath(const std::string &source_path);
+
+   private:
+    MappedFile file;
+    std::vector<uint64_t> mesh_offsets;
+    std::vector<std::string> mesh_names;
+    bool valid = false;
+    bool partial = false;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <learnopengl/mesh.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// post transform vertex cache size the optimizer and the statistics assume
+#define VERTEX_CACHE_SIZE 16
+
+// post transform vertex cache efficiency of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats {
+    // average cache miss ratio: vertices transformed per triangle, from 3 (no reuse) down to
+    // about 0.5 for a regular grid
+    float acmr = 0;
+    // average transform to vertex ratio: how often each vertex is transformed, 1 is optimal
+    float atvr = 0;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t num_vertices,
+                                    unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+// reorders the triangles for the post transform vertex cache (Tipsify, Sander et al. 2007).
+// Returns the index offsets at which the order had to jump to an unrelated vertex, these split the
+// triangles into clusters that optimizeOverdraw() can reorder without hurting the cache much.
+std::vector<size_t> optimizeVertexCache(std::vector<unsigned int> &indices, size_t num_vertices,
+                                        unsigned int cache_size = VERTEX_CACHE_SIZE);
+
+// reorders the clusters returned by optimizeVertexCache() so the ones facing outwards of the mesh
+// are drawn first and occlude the rest
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                      const std::vector<size_t> &clusters);
+
+// reorders the vertices in the order the indices first use them, so vertex fetch walks the
+// vertex buffer linearly. Vertices no triangle uses are dropped.
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+// runs the three passes above on a mesh and returns the cache statistics before and after
+std::pair<VertexCacheStats, VertexCacheStats> optimizeMesh(MeshData &mesh);
+
+#endif
\ No newline at end of file
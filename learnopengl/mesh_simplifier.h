@@ -0,0 +1,30 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <learnopengl/mesh.h>
+
+#include <cstddef>
+#include <vector>
+
+// simplifies a triangle list with quadric error edge collapses (Garland & Heckbert 1997) until
+// it has at most target_index_count indices or the next collapse would move the surface further
+// than target_error (relative to the mesh extent). A collapse moves a vertex onto one of its
+// neighbours, so the vertices are not changed and all LODs can share one vertex buffer.
+//
+// All vertices at one position collapse together. On a UV/normal seam each of them moves to the
+// vertex on its side of the seam, so a collapse is only made along the seam, never across it.
+// Duplicate vertices (same position, normal and texture coordinates) are merged first. Vertices on
+// open borders are never moved, which keeps the outline of open surfaces intact. The error is the
+// area weighted mean distance of a collapsed vertex to the planes of its original triangles;
+// stores the relative error of the result in result_error if it isn't null.
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex> &vertices,
+                                       const std::vector<unsigned int> &indices,
+                                       size_t target_index_count, float target_error,
+                                       float *result_error = nullptr);
+
+// builds a LOD chain for mesh: every LOD has about half the triangles of the previous one, up to
+// max_lods levels including the full mesh or until the error exceeds max_error. The indices of
+// the coarser LODs are appended to mesh.indices and mesh.lods describes all levels.
+void generateLods(MeshData &mesh, size_t max_lods, float max_error);
+
+#endif
\ No newline at end of file
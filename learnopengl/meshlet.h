@@ -0,0 +1,42 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct Vertex;
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// a cluster of neighbouring triangles of a mesh, a contiguous range of its index buffer. The
+// bounding sphere and the normal cone let the renderer cull clusters that are out of the
+// frustum or face away from the camera.
+struct Meshlet {
+    uint32_t index_offset = 0;
+    uint32_t num_indices = 0;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    // all triangle normals are within the cone around cone_axis, cone_cutoff is the sine of its
+    // half angle (1 when the cone is too wide to ever cull)
+    glm::vec3 cone_axis = glm::vec3(0.0f);
+    float cone_cutoff = 1.0f;
+
+    // true if every triangle of the meshlet faces away from camera_pos (in model space)
+    bool isBackfacing(const glm::vec3 &camera_pos) const {
+        glm::vec3 view = center - camera_pos;
+        return glm::dot(view, cone_axis) >= cone_cutoff * glm::length(view) + radius;
+    }
+};
+
+// splits the first num_indices indices into meshlets of at most max_vertices unique vertices
+// and max_triangles triangles, in index order. The indices are not changed, so they should
+// already be ordered for the vertex cache (see optimizeVertexCache) for compact meshlets.
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex> &vertices,
+                                   const std::vector<unsigned int> &indices, size_t num_indices,
+                                   size_t max_vertices = MESHLET_MAX_VERTICES,
+                                   size_t max_triangles = MESHLET_MAX_TRIANGLES);
+
+#endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <assimp/scene.h>
 #include <glad/glad.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
 #include <learnopengl/shader.h>
 
 #include <assimp/Importer.hpp>
@@ -13,11 +14,120 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
+// Assimp post processing steps an import runs, from the quickest to the most thorough. The
+// resulting vertex/index counts and import time are logged by Model::loadData, and the model
+// loading benchmark compares them with --presets.
+enum class ImportPreset {
+    // triangulates and generates flat normals where the file has none, nothing else: the
+    // quickest way to look at an asset. Without tangents normal maps don't work, and every
+    // corner of every triangle is a vertex of its own.
+    FastPreview,
+    // the Exact steps plus joining identical vertices, reordering for the vertex cache, merging
+    // meshes and nodes and removing redundant materials: the fewest vertices and draw calls.
+    // Merged meshes lose their names, so such models should be loaded whole.
+    RuntimeOptimized,
+    // triangulated meshes with smooth normals and tangents, otherwise as in the file. Mesh names
+    // and structure are kept, but vertices aren't joined, so OBJ files come out with three
+    // vertices per triangle.
+    Exact
+};
+
+// "fast-preview", "runtime-optimized" or "exact"
+const char *importPresetName(ImportPreset preset);
+// parses a name returned by importPresetName, returns false if there is no such preset
+bool parseImportPreset(const std::string &name, ImportPreset &preset);
+// the Assimp post processing flags of preset
+unsigned int importFlags(ImportPreset preset);
+
+// options controlling how a Model is imported
+struct ModelLoadOptions {
+    // post processing of the import, part of the mesh cache key
+    ImportPreset import_preset = ImportPreset::Exact;
+    // read the meshes from the binary mesh cache next to the model file when it is up to date and
+    // (re)write it after an import
+    bool use_cache = true;
+    // convert the imported meshes and decode the textures on the worker threads of
+    // ThreadPool::global(). Only the GL uploads run on the calling (context) thread.
+    bool parallel = true;
+    // reorder the triangles and vertices of imported meshes for the vertex cache, overdraw and
+    // vertex fetch (see optimizeMesh). The result is stored in the mesh cache, so the cost is
+    // only paid by the first import.
+    bool optimize = true;
+    // number of levels of detail generated for every imported mesh, including the full detail
+    // one (see generateLods). 1 disables LOD generation. Stored in the mesh cache as well.
+    size_t max_lods = 1;
+    // LOD generation stops when the simplification error exceeds this, relative to the mesh
+    // extent
+    float max_lod_error = 0.05f;
+    // split the full detail level of every imported mesh into meshlets, which the renderer can
+    // cull individually (see Mesh::DrawMeshlets). Stored in the mesh cache as well.
+    bool build_meshlets = false;
+    // layout of the uploaded vertex buffers, see VertexFormat
+    VertexFormat vertex_format = VertexFormat::Packed;
+    // keep CPU copies of the vertices and indices after the upload (for picking or physics)
+    CpuResidency cpu_residency = CpuResidency::Release;
+    // read Wavefront OBJ files with the built-in parser (see loadObj), which does the steps of
+    // FastPreview and Exact itself. Assimp still reads every other format, the OBJ files the
+    // parser rejects and all files with ImportPreset::RuntimeOptimized, which restructures the
+    // meshes.
+    bool native_obj = true;
+    // buffer the vertices and indices are uploaded into, so several models (e.g. all models of a
+    // scene) can share one VAO per vertex layout. Each model gets a buffer of its own if null.
+    std::shared_ptr<GeometryBuffer> geometry_buffer;
+    // once the meshes are uploaded, copy the textures of the model that share size and format
+    // into texture arrays (see Model::packTextureArrays). The copy isn't counted against the
+    // upload budget of uploadStep.
+    bool texture_arrays = false;
+};
+
+// wall clock time Model::loadData spent in each phase, in milliseconds
+struct ModelLoadTimings {
+    // mapping the mesh cache, or reading and parsing the file (Assimp or the OBJ parser)
+    double import_ms = 0;
+    // converting the imported meshes, including the optimizer, LOD and meshlet passes
+    double convert_ms = 0;
+    // writing the mesh cache after an import
+    double cache_write_ms = 0;
+    // decoding the textures ahead of the upload
+    double decode_ms = 0;
+    // true if the meshes came from the mesh cache
+    bool from_cache = false;
+};
+
+// CPU side result of loading a model file, produced by Model::loadData (possibly on a worker
+// thread) and uploaded to GL by Model::uploadStep.
+struct ModelData {
+    std::string path;
+    std::string directory;
+    // owns the vertex/index arrays of freshly imported meshes
+    std::vector<MeshData> imported;
+    // or owns the mapping the meshes point into when they came from the mesh cache
+    std::unique_ptr<MeshCache> cache;
+    // the requested meshes, in upload order
+    std::vector<MeshView> meshes;
+    // textures decoded ahead of the upload, keyed by TextureRef::path. Textures not found here are
+    // decoded during the upload.
+    std::map<std::string, ImageData> images;
+    // number of meshes uploaded so far
+    size_t next_mesh = 0;
+    VertexFormat vertex_format = VertexFormat::Packed;
+    CpuResidency cpu_residency = CpuResidency::Release;
+    std::shared_ptr<GeometryBuffer> geometry_buffer;
+    // run Model::packTextureArrays after the last mesh is uploaded
+    bool texture_arrays = false;
+    ModelLoadTimings timings;
+    // totals over the requested meshes, counting the indices of the full detail level only
+    size_t num_vertices = 0;
+    size_t num_indices = 0;
+};
+
 class Model {
    public:
     // model data
@@ -25,33 +135,100 @@ class Model {
                                            // make sure textures aren't loaded more than once.
     std::vector<Mesh> meshes;
     std::string directory;
-    bool gammaCorrection;
+    bool gammaCorrection = false;
 
     // constructor, expects a filepath to a 3D model.
     Model(std::string const &path, const std::vector<std::string> &mesh_names = {},
-          bool gamma = false)
+          bool gamma = false, const ModelLoadOptions &options = {})
         : gammaCorrection(gamma) {
-        loadModel(path, mesh_names);
+        loadModel(path, mesh_names, options);
     }
+    // creates an empty model, to be filled by uploadStep()
+    Model() = default;
+    // releases the references on the textures and texture arrays in TextureCache::global(), the
+    // GL textures are deleted by TextureCache::purge()
+    ~Model();
+
+    // a model holds references on its textures, so it can be moved but not copied
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+    Model(Model &&other) noexcept;
+    Model &operator=(Model &&other) noexcept;
 
     // draws the model, and thus all its meshes
     void Draw(Shader &shader) const;
+    // copies the diffuse, specular and reflection textures that share size and format into
+    // texture arrays (see packTextureArrays) and makes the meshes sample them from there. The
+    // model releases the packed 2D textures, so purging deletes the ones no other model uses;
+    // their ids in the textures of the meshes are only names of the layers afterwards.
+    void packTextureArrays();
+
+    // bytes of CPU memory held for the geometry of the meshes
+    size_t residentBytes() const;
+    // bounds of all meshes in model space
+    const Bounds &getBounds() const { return bounds; }
+    // the buffer holding the vertices and indices of the meshes, null before the upload
+    const GeometryBuffer *getGeometryBuffer() const { return geometry.get(); }
+
+    // loads a model with supported ASSIMP extensions (or its mesh cache) from file without
+    // touching GL, so it can run on a worker thread. With decode_textures the referenced textures
+    // are decoded as well, concurrently when options.parallel is set.
+    static ModelData loadData(std::string const &path, const std::vector<std::string> &mesh_names,
+                              const ModelLoadOptions &options, bool decode_textures);
+
+    // uploads the textures and meshes of data that are not uploaded yet, subtracting the size of
+    // the uploaded vertex/index/texel data from budget_bytes. Stops once the budget is used up;
+    // the item that exceeds it is still uploaded, so a non-zero budget always makes progress.
+    // Returns true when the whole model is uploaded. Must be called on the GL thread.
+    bool uploadStep(ModelData &data, size_t &budget_bytes);
 
    private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in
-    // the meshes vector.
-    void loadModel(std::string const &path, const std::vector<std::string> &mesh_names);
+    // loads a model and uploads it right away
+    void loadModel(std::string const &path, const std::vector<std::string> &mesh_names,
+                   const ModelLoadOptions &options);
+
+    // collects the requested meshes of an up to date mesh cache, returns false if there is none.
+    // If a partial cache lacks some of the requested meshes, the names of the meshes it holds
+    // are stored in cached_names, so the reimport can keep them in the cache.
+    static bool loadFromCache(ModelData &data, const std::vector<std::string> &mesh_names,
+                              const ModelLoadOptions &options,
+                              std::vector<std::string> &cached_names);
+
+    // imports the meshes named in import_names (all if it is empty) with Assimp and converts
+    // them concurrently when options.parallel is set
+    static void importMeshes(std::string const &path, const std::vector<std::string> &import_names,
+                             const ModelLoadOptions &options, std::vector<MeshData> &meshes_data,
+                             ModelLoadTimings &timings);
+
+    // processes a node in a recursive fashion. Collects each individual mesh located at the node
+    // and repeats this process on its children nodes (if any), so the meshes come out in
+    // traversal order.
+    static void processNode(aiNode *node, const aiScene *scene,
+                            const std::vector<std::string> &mesh_names,
+                            std::vector<aiMesh *> &ai_meshes);
+
+    // converts an assimp mesh to MeshData, optimizing it and building its LODs if requested.
+    // Doesn't touch GL or the model, so it is safe to call for several meshes concurrently.
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene,
+                                const ModelLoadOptions &options);
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node
-    // and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene,
-                     const std::vector<std::string> &mesh_names);
+    // checks all material textures of a mesh and loads the textures if they're not loaded yet,
+    // taking already decoded images from data. the required info is returned as Texture structs
+    // with the role of their reference. Returns false if the budget ran out before all textures
+    // were loaded.
+    bool loadMaterialTextures(ModelData &data, const std::vector<TextureRef> &refs,
+                              size_t &budget_bytes, std::vector<Texture> &textures);
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+    // drops the references on textures_loaded and texture_arrays
+    void releaseTextures();
 
-    // checks all material textures of a given type and loads the textures if they're not loaded
-    // yet. the required info is returned as a Texture struct.
-    std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type);
+    Bounds bounds;
+    // shared with other models if ModelLoadOptions::geometry_buffer was set
+    std::shared_ptr<GeometryBuffer> geometry;
+    // index into textures_loaded by TextureRef::path
+    std::unordered_map<std::string, size_t> textures_loaded_index;
+    // the arrays packTextureArrays made, referenced in TextureCache::global()
+    std::vector<unsigned int> texture_arrays;
 };
 
 struct RenderModel {
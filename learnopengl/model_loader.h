@@ -0,0 +1,56 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <learnopengl/model.h>
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+// progress of a model requested from a ModelLoader
+class ModelHandle {
+   public:
+    const std::string &path() const { return file_path; }
+    bool isReady() const { return state == State::Ready; }
+    bool isFailed() const { return state == State::Failed; }
+    const std::string &error() const { return error_message; }
+
+    // moves the uploaded model out of the handle, throws unless isReady()
+    Model takeModel();
+
+   private:
+    friend class ModelLoader;
+    enum class State { Loading, Uploading, Ready, Failed };
+
+    std::string file_path;
+    State state = State::Loading;
+    std::future<ModelData> pending;
+    ModelData data;
+    Model model;
+    std::string error_message;
+};
+
+// streams models in without blocking the render loop. File I/O, importing (or mapping the mesh
+// cache), mesh conversion and texture decoding run on ThreadPool::global(); the VBO/EBO/texture
+// uploads are spread over frames by processUploads().
+class ModelLoader {
+   public:
+    // starts loading a model and returns immediately
+    std::shared_ptr<ModelHandle> load(const std::string &path,
+                                      const std::vector<std::string> &mesh_names = {},
+                                      const ModelLoadOptions &options = {});
+
+    // uploads loaded models, at most budget_bytes of vertex/index/texel data per call (the item
+    // crossing the budget is still uploaded). Call once per frame on the GL thread. Returns the
+    // handles that became ready or failed during this call.
+    std::vector<std::shared_ptr<ModelHandle>> processUploads(size_t budget_bytes);
+
+    bool isIdle() const { return handles.empty(); }
+
+   private:
+    // requests in flight, uploaded in request order
+    std::vector<std::shared_ptr<ModelHandle>> handles;
+};
+
+#endif
\ No newline at end of file
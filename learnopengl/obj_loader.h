@@ -0,0 +1,42 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <learnopengl/mesh.h>
+
+#include <string>
+#include <vector>
+
+// fast path for Wavefront OBJ/MTL files, which all models in resources/objects are. The file is
+// mapped and tokenized in place, split into line ranges that are parsed concurrently.
+//
+// The meshes match the ones the Assimp import (with the flags of the ImportPreset Model uses)
+// produces: one mesh per object/group and material, named after the object, with triangulated
+// faces, flipped texture coordinates, normals where the file has none and tangents, as
+// ObjLoadOptions asks for.
+
+// the post processing of loadObj, the counterpart of the Assimp flags of an ImportPreset
+struct ObjLoadOptions {
+    // corners using the same position/UV/normal indices share one vertex. Otherwise every
+    // corner is a vertex of its own, as Assimp imports OBJ files without
+    // aiProcess_JoinIdenticalVertices.
+    bool join_vertices = true;
+    // normals generated where the file has none are averaged over the faces around a position
+    // (aiProcess_GenSmoothNormals), otherwise they are the normal of the face
+    // (aiProcess_GenNormals, only without join_vertices)
+    bool smooth_normals = true;
+    // compute tangents and bitangents (aiProcess_CalcTangentSpace). Corners that would be joined
+    // get the same ones either way.
+    bool tangents = true;
+};
+
+// true if path has the .obj extension (case insensitive)
+bool isObjFile(const std::string &path);
+
+// parses the OBJ file at path and the material libraries it references into meshes, in file
+// order. Only the meshes named in mesh_names are built, all of them if it is empty. Uses the
+// worker threads of ThreadPool::global() when parallel is set. Returns false if the file can't
+// be read or uses something the fast path doesn't handle, the caller then falls back to Assimp.
+bool loadObj(const std::string &path, const std::vector<std::string> &mesh_names, bool parallel,
+             const ObjLoadOptions &options, std::vector<MeshData> &meshes);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// draws of a frame, ordered by a 64 bit key before they are submitted. The key packs the pass,
+// the program, the material, the VAO and the distance to the camera, so sorting puts draws
+// sharing state next to each other and GLState skips most of the binds between them:
+//
+//   opaque:       pass:2 | program:10 | material:16 | vao:12 | depth:24   (front to back)
+//   transparent:  pass:2 | far depth:24 | program:10 | material:16 | vao:12   (back to front)
+//
+// Fields are truncated to their width, so two programs (materials, VAOs) that share the low bits
+// are only sorted as if they were the same one. The order stays correct for the fields above.
+class RenderQueue {
+   public:
+    enum class Pass : uint8_t { Opaque = 0, Transparent = 1 };
+
+    struct Packet {
+        uint64_t key;
+        // what to draw, e.g. an index into the caller's list of meshes
+        uint32_t index;
+    };
+
+    // depth is the distance to the camera
+    static uint64_t makeKey(Pass pass, uint32_t program, uint32_t material, uint32_t vao,
+                            float depth);
+
+    void clear() { packets.clear(); }
+    void push(uint64_t key, uint32_t index) { packets.push_back(Packet{key, index}); }
+    // sorts the packets by key with a radix sort. Packets with equal keys keep the order they
+    // were pushed in.
+    void sort();
+
+    const std::vector<Packet> &getPackets() const { return packets; }
+    size_t size() const { return packets.size(); }
+
+   private:
+    std::vector<Packet> packets;
+    // second buffer of the radix sort, kept to not allocate every frame
+    std::vector<Packet> scratch;
+};
+
+#endif
\ No newline at end of file
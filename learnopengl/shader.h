@@ -3,11 +3,50 @@
 
 #include <glad/glad.h>
 
+#include <cstdint>
 #include <fstream>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t UNIFORM_HASH_SEED = 2166136261u;
+
+// FNV-1a hash of a uniform name, evaluated at compile time for constants. seed is the hash of
+// the text before name, so uniformHash("position", uniformHash("light.")) is the hash of
+// "light.position".
+constexpr uint32_t uniformHash(std::string_view name, uint32_t seed = UNIFORM_HASH_SEED) {
+    uint32_t hash = seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// continues the hash seed with the decimal digits of index, for names like "pointLights[2]"
+constexpr uint32_t uniformHash(unsigned int index, uint32_t seed) {
+    char digits[10] = {};
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + index % 10);
+        index /= 10;
+    } while (index > 0);
+    uint32_t hash = seed;
+    while (count > 0) {
+        hash = (hash ^ static_cast<unsigned char>(digits[--count])) * 16777619u;
+    }
+    return hash;
+}
+
+// location of an active uniform of a Shader, resolved once through Shader::uniform(). Setting a
+// uniform the program doesn't use (location -1) is ignored by GL, like with the name setters.
+struct Uniform {
+    GLint location = -1;
+
+    bool isActive() const { return location >= 0; }
+};
 
 class Shader {
    public:
@@ -18,6 +57,13 @@ class Shader {
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const;
+    // handle of the active uniform whose name hashes to name_hash (see uniformHash). Looked up
+    // in the table of active uniforms built at link time, never asks the driver.
+    Uniform uniform(uint32_t name_hash) const;
+    Uniform uniform(std::string_view name) const { return uniform(uniformHash(name)); }
+    // binds the uniform block block_name to the uniform buffer binding point binding, does
+    // nothing if the program has no such block
+    void setUniformBlockBinding(const char *block_name, unsigned int binding) const;
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value);
@@ -41,8 +87,43 @@ class Shader {
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat);
 
+    // the same setters taking handles, for the hot paths: they neither allocate nor query GL.
+    // The shader must be in use.
+    // ------------------------------------------------------------------------
+    void setBool(Uniform uniform, bool value) const { glUniform1i(uniform.location, value); }
+    void setInt(Uniform uniform, int value) const { glUniform1i(uniform.location, value); }
+    void setFloat(Uniform uniform, float value) const { glUniform1f(uniform.location, value); }
+    void setVec2(Uniform uniform, const glm::vec2 &value) const {
+        glUniform2fv(uniform.location, 1, &value[0]);
+    }
+    void setVec3(Uniform uniform, const glm::vec3 &value) const {
+        glUniform3fv(uniform.location, 1, &value[0]);
+    }
+    void setVec3(Uniform uniform, float x, float y, float z) const {
+        glUniform3f(uniform.location, x, y, z);
+    }
+    void setVec4(Uniform uniform, const glm::vec4 &value) const {
+        glUniform4fv(uniform.location, 1, &value[0]);
+    }
+    void setMat3(Uniform uniform, const glm::mat3 &mat) const {
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(Uniform uniform, const glm::mat4 &mat) const {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+
    private:
+    struct UniformEntry {
+        uint32_t hash;
+        GLint location;
+    };
+    // active uniforms sorted by the hash of their name. Array elements are listed under
+    // "name[i]" and the first one under "name" as well.
+    std::vector<UniformEntry> uniforms;
+
     GLint getUniformLocation(const std::string &name);
+    // fills uniforms from the linked program
+    void collectUniforms();
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     bool checkCompileErrors(unsigned int shader, std::string type);
@@ -3,17 +3,78 @@
 
 #include <glad/glad.h>  // holds all OpenGL type declarations
 
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 
+// what a material uses a texture for. The samplers of a role are named after it, see
+// textureRoleName.
+enum class TextureRole : uint8_t { Diffuse, Specular, Normal, Height, Reflection };
+constexpr size_t NUM_TEXTURE_ROLES = 5;
+
+// "texture_diffuse", "texture_specular", "texture_normal", "texture_height" or
+// "texture_reflection", the shaders add a number to it
+const char* textureRoleName(TextureRole role);
+// parses a name returned by textureRoleName, returns false if there is no such role
+bool parseTextureRole(std::string_view name, TextureRole& role);
+
 struct Texture {
-    unsigned int id;
-    unsigned int num_components;
-    std::string type;
+    unsigned int id = 0;
+    unsigned int num_components = 0;
+    TextureRole role = TextureRole::Diffuse;
     std::string path;
+    // the GL_TEXTURE_2D_ARRAY and layer packTextureArrays copied the texture to, 0 if it isn't
+    // packed
+    unsigned int array_id = 0;
+    int layer = 0;
+};
+
+// parameters a texture is uploaded with
+struct TextureParams {
+    // upload color images in an sRGB format
+    bool srgb = false;
+    // wrap mode for S and T, 0 picks GL_CLAMP_TO_EDGE for RGBA images and GL_REPEAT otherwise
+    GLint wrap = 0;
+    GLint min_filter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint mag_filter = GL_LINEAR;
+
+    bool operator==(const TextureParams& other) const {
+        return srgb == other.srgb && wrap == other.wrap && min_filter == other.min_filter &&
+               mag_filter == other.mag_filter;
+    }
+};
+
+struct ImageDeleter {
+    void operator()(unsigned char* pixels) const;
+};
+
+// pixels of an image decoded from file. Decoding doesn't need a GL context, so it can happen on a
+// worker thread while the upload happens later on the GL thread.
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int num_components = 0;
+    std::unique_ptr<unsigned char, ImageDeleter> pixels;
+
+    size_t sizeInBytes() const { return static_cast<size_t>(width) * height * num_components; }
 };
 
+// decodes an image file, throws if it can't be loaded. Thread safe.
+ImageData decodeImage(const std::string& path);
+// decodes an image file on ThreadPool::global(), the future rethrows decode errors
+std::future<ImageData> decodeImageAsync(const std::string& path);
+// decodes all images concurrently on ThreadPool::global(), in the order of paths
+std::vector<ImageData> decodeImages(const std::vector<std::string>& paths);
+
+// creates a 2D texture with mipmaps from a decoded image, returns the texture id and the number
+// of color components
+std::pair<unsigned int, unsigned int> uploadTexture(const ImageData& image,
+                                                    const TextureParams& params = {});
+
 // utility function for loading a 2D texture from file
 // ---------------------------------------------------
 std::pair<unsigned int, unsigned int> loadTexturePair(const std::string& path,
@@ -28,9 +89,11 @@ unsigned int loadTexture(const std::string& path, bool gammaCorrection = false);
 // -Y (bottom)
 // +Z (front)
 // -Z (back)
+// all faces are decoded concurrently and each face is uploaded as soon as it is decoded
 // -------------------------------------------------------
 unsigned int loadCubemap(std::vector<std::string> faces);
 
+// loads a texture through TextureCache::global(), so every caller shares one GL texture per file
 Texture TextureFromFile(std::string_view filename, const std::string& directory);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <glad/glad.h>
+#include <learnopengl/texture.h>
+
+#include <unordered_map>
+#include <vector>
+
+// texture unit of the first GL_TEXTURE_2D_ARRAY Mesh::bindMaterial binds. The arrays of the
+// diffuse, specular and reflection textures go to this unit and the two after it.
+constexpr GLuint TEXTURE_ARRAY_UNIT = 8;
+
+// where packTextureArrays copied a 2D texture to
+struct TextureLayer {
+    unsigned int array = 0;
+    int layer = 0;
+};
+
+// copies 2D textures into GL_TEXTURE_2D_ARRAY textures, one array for every size, internal format
+// and sampling parameters that at least two of the textures share. Meshes whose textures are
+// layers of the same arrays are drawn without binding any texture in between. Returns the layer
+// of every packed texture by the id of the 2D texture; textures sharing their format with no
+// other one aren't packed. The 2D textures are left as they are, the caller owns the arrays and
+// releases the 2D textures it no longer samples (see Model::packTextureArrays).
+//
+// GL 3.3 has no glCopyImageSubData, so the texels take a round trip through glGetTexImage, which
+// waits for the uploads of the textures: a load time step, not one for every frame. Must be called
+// on the GL thread.
+std::unordered_map<unsigned int, TextureLayer> packTextureArrays(
+    const std::vector<Texture> &textures);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <learnopengl/texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// process wide cache of 2D textures shared by all models. Textures are keyed by the canonical
+// file path plus the upload parameters and reference counted: every acquire() must be paired with
+// a release(). Unreferenced textures stay resident until purge() deletes them, so releasing never
+// needs a current GL context. Nothing purges on its own: whoever unloads models calls purge() on
+// the GL thread afterwards, as Scene::Clear() does.
+//
+// Lookups are thread safe, so loader threads can skip decoding images that are already cached.
+// acquire() and purge() call into GL and must run on the GL thread.
+class TextureCache {
+   public:
+    static TextureCache &global();
+
+    // returns the cached texture for path/params and takes a reference on it, uploading decoded
+    // (or the decoded file if decoded is null) when it isn't cached yet
+    Texture acquire(const std::string &path, const TextureParams &params = {},
+                    const ImageData *decoded = nullptr);
+    // like acquire(), but never uploads: returns false if the texture isn't cached
+    bool tryAcquire(const std::string &path, const TextureParams &params, Texture &texture);
+    bool contains(const std::string &path, const TextureParams &params = {});
+
+    // takes a reference on a texture made elsewhere (e.g. a texture array), so it is deleted by
+    // purge() like the cached ones once released. It can't be acquired by path.
+    void adopt(unsigned int id);
+    // drops a reference taken by acquire()/tryAcquire()/adopt()
+    void release(unsigned int id);
+    // deletes the GL textures nobody references anymore, returns how many were deleted
+    size_t purge();
+
+    // when enabled, a newly decoded image is hashed and images with identical pixels and
+    // parameters share one GL texture even when loaded from different files
+    void setContentDedup(bool enable) { content_dedup = enable; }
+
+    size_t size() const;
+
+   private:
+    struct Key {
+        std::string path;
+        TextureParams params;
+        bool operator==(const Key &other) const {
+            return path == other.path && params == other.params;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+    struct Entry {
+        Texture texture;
+        size_t refs = 0;
+        uint64_t content_hash = 0;
+        TextureParams params;
+    };
+
+    Key makeKey(const std::string &path, const TextureParams &params);
+    Texture addRef(Entry &entry);
+
+    mutable std::mutex mutex;
+    // canonical form of every path seen so far, so canonicalization touches the file system once
+    std::unordered_map<std::string, std::string> canonical_paths;
+    std::unordered_map<Key, unsigned int, KeyHash> ids;
+    std::unordered_map<unsigned int, Entry> entries;
+    // texture ids by content hash, only filled with content dedup enabled
+    std::unordered_multimap<uint64_t, unsigned int> content_ids;
+    bool content_dedup = false;
+};
+
+#endif
\ No newline at end of file
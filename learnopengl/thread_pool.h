@@ -0,0 +1,57 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// fixed size pool of worker threads for CPU side loading work. Nothing submitted here may call
+// into GL, the context only lives on the main thread.
+class ThreadPool {
+   public:
+    explicit ThreadPool(size_t num_threads = defaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // queues a task and returns a future for its result
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&task) {
+        auto packaged =
+            std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+        auto result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    // calls fn(i) for every i in [0, count) on the pool and returns when all calls finished. The
+    // calling thread takes part in the work, so it is safe to use from inside a pool task. The
+    // first exception thrown by fn is rethrown here.
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    size_t size() const { return workers.size(); }
+
+    // pool shared by all loaders of the process
+    static ThreadPool &global();
+    static size_t defaultThreadCount();
+
+   private:
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+};
+
+#endif
\ No newline at end of file
@@ -7,18 +7,51 @@ struct Material {
     sampler2D texture_diffuse1;
     sampler2D texture_specular1;
     sampler2D texture_reflection1;
-    
+    // sampled instead of the 2D textures where the layer isn't -1, see packTextureArrays
+    sampler2DArray texture_diffuse_array;
+    sampler2DArray texture_specular_array;
+    sampler2DArray texture_reflection_array;
+}; 
+  
+uniform Material material;
+
+// written once per material, see MaterialBlock in learnopengl/material_buffer.h
+layout(std140) uniform MaterialBlock {
     vec3 color_ambient;
+    float shininess;
     vec3 color_diffuse;
+    float dissolve;
     vec3 color_specular;
+    bool use_diffuse_alpha;
+    int diffuse_layer;
+    int specular_layer;
+    int reflection_layer;
+} materialBlock;
 
+// set while an IndirectDrawList draws, the material of each draw is then read from draw_data,
+// the last four of the eight texels of the draw
+uniform bool use_draw_data;
+uniform samplerBuffer draw_data;
+flat in int DrawIndex;
+
+// the members of MaterialBlock, taken from the block or from the draw data
+struct MaterialConstants {
+    vec3 color_ambient;
     float shininess;
+    vec3 color_diffuse;
     float dissolve;
-
+    vec3 color_specular;
     bool use_diffuse_alpha;
-}; 
-  
-uniform Material material;
+    int diffuse_layer;
+    int specular_layer;
+    int reflection_layer;
+};
+MaterialConstants constants;
+
+MaterialConstants loadConstants();
+vec4 diffuseTexel();
+float specularTexel();
+float reflectionTexel();
 uniform samplerCube skybox;
 
 struct DirLight {
@@ -75,6 +108,7 @@ in vec3 Position;
 
 void main()
 {
+    constants = loadConstants();
     // properties
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
@@ -89,15 +123,69 @@ void main()
     
     vec3 I = normalize(Position - viewPos);
     vec3 R = reflect(I, normalize(Normal));
-    result = result + texture(skybox, R).rgb * texture(material.texture_reflection1, TexCoords).r;
+    result = result + texture(skybox, R).rgb * reflectionTexel();
     
-    float alpha = material.dissolve;
-    if(material.use_diffuse_alpha)
-        alpha = texture(material.texture_diffuse1, TexCoords).a;
+    float alpha = constants.dissolve;
+    if(constants.use_diffuse_alpha)
+        alpha = diffuseTexel().a;
 
     FragColor = vec4(result, alpha);
 }
 
+MaterialConstants loadConstants()
+{
+    MaterialConstants c;
+    if (!use_draw_data) {
+        c.color_ambient = materialBlock.color_ambient;
+        c.shininess = materialBlock.shininess;
+        c.color_diffuse = materialBlock.color_diffuse;
+        c.dissolve = materialBlock.dissolve;
+        c.color_specular = materialBlock.color_specular;
+        c.use_diffuse_alpha = materialBlock.use_diffuse_alpha;
+        c.diffuse_layer = materialBlock.diffuse_layer;
+        c.specular_layer = materialBlock.specular_layer;
+        c.reflection_layer = materialBlock.reflection_layer;
+        return c;
+    }
+    int texel = DrawIndex * 8 + 4;
+    vec4 ambient = texelFetch(draw_data, texel);
+    vec4 diffuse = texelFetch(draw_data, texel + 1);
+    vec4 specular = texelFetch(draw_data, texel + 2);
+    ivec4 layers = ivec4(texelFetch(draw_data, texel + 3));
+    c.color_ambient = ambient.rgb;
+    c.shininess = ambient.a;
+    c.color_diffuse = diffuse.rgb;
+    c.dissolve = diffuse.a;
+    c.color_specular = specular.rgb;
+    c.use_diffuse_alpha = specular.a != 0.0;
+    c.diffuse_layer = layers.x;
+    c.specular_layer = layers.y;
+    c.reflection_layer = layers.z;
+    return c;
+}
+
+vec4 diffuseTexel()
+{
+    if (constants.diffuse_layer < 0)
+        return texture(material.texture_diffuse1, TexCoords);
+    return texture(material.texture_diffuse_array, vec3(TexCoords, constants.diffuse_layer));
+}
+
+float specularTexel()
+{
+    if (constants.specular_layer < 0)
+        return texture(material.texture_specular1, TexCoords).r;
+    return texture(material.texture_specular_array, vec3(TexCoords, constants.specular_layer)).r;
+}
+
+float reflectionTexel()
+{
+    if (constants.reflection_layer < 0)
+        return texture(material.texture_reflection1, TexCoords).r;
+    return texture(material.texture_reflection_array,
+                   vec3(TexCoords, constants.reflection_layer)).r;
+}
+
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 {
     vec3 lightDir = normalize(-light.direction);
@@ -105,14 +193,14 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), constants.shininess);
     // combine results
-    vec3 ambient  = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_ambient;
-    vec3 diffuse  = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_diffuse;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords).r)
-    * material.color_specular;
+    vec3 ambient  = light.ambient * vec3(diffuseTexel())
+    * constants.color_ambient;
+    vec3 diffuse  = light.diffuse * diff * vec3(diffuseTexel())
+    * constants.color_diffuse;
+    vec3 specular = light.specular * spec * vec3(specularTexel())
+    * constants.color_specular;
     return (ambient + diffuse + specular);
 }
 
@@ -123,18 +211,18 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), constants.shininess);
     // attenuation
     float distance    = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + 
   			     light.quadratic * (distance * distance));    
     // combine results
-    vec3 ambient  = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_ambient;
-    vec3 diffuse  = light.diffuse * diff * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_diffuse;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords).r)
-    * material.color_specular;
+    vec3 ambient  = light.ambient * vec3(diffuseTexel())
+    * constants.color_ambient;
+    vec3 diffuse  = light.diffuse * diff * vec3(diffuseTexel())
+    * constants.color_diffuse;
+    vec3 specular = light.specular * spec * vec3(specularTexel())
+    * constants.color_specular;
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
@@ -150,14 +238,14 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
     float diff = max(dot(normal, lightDir), 0.0);
     // specular
     vec3 reflectDir = reflect(-lightDir, normal);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-
-    vec3 ambient = light.ambient * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_ambient;
-    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material.texture_diffuse1, TexCoords))
-    * material.color_diffuse;
-    vec3 specular = light.specular * spec * vec3(texture(material.texture_specular1, TexCoords).r)
-    * material.color_specular;
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), constants.shininess);
+
+    vec3 ambient = light.ambient * vec3(diffuseTexel())
+    * constants.color_ambient;
+    vec3 diffuse  = light.diffuse  * diff * vec3(diffuseTexel())
+    * constants.color_diffuse;
+    vec3 specular = light.specular * spec * vec3(specularTexel())
+    * constants.color_specular;
 
     float distance    = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + 
@@ -2,21 +2,40 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// index of the draw in an IndirectDrawList
+layout (location = 7) in uint aDrawIndex;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// set while an IndirectDrawList draws, the model matrix of each draw is then read from
+// draw_data, the first four of the eight texels of the draw
+uniform bool use_draw_data;
+uniform samplerBuffer draw_data;
 
 out vec3 FragPos;  
 out vec3 Normal;
 out vec2 TexCoords;
 out vec3 Position;
+// the fragment shader reads the material of the draw with it
+flat out int DrawIndex;
+
+mat4 drawModel()
+{
+    if (!use_draw_data)
+        return model;
+    int texel = int(aDrawIndex) * 8;
+    return mat4(texelFetch(draw_data, texel), texelFetch(draw_data, texel + 1),
+                texelFetch(draw_data, texel + 2), texelFetch(draw_data, texel + 3));
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    mat4 modelMatrix = drawModel();
+    gl_Position = projection * view * modelMatrix * vec4(aPos, 1.0);
+    FragPos = vec3(modelMatrix * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(modelMatrix))) * aNormal;
     TexCoords = aTexCoords;
-    Position = vec3(model * vec4(aPos, 1.0));
+    Position = vec3(modelMatrix * vec4(aPos, 1.0));
+    DrawIndex = int(aDrawIndex);
 }
\ No newline at end of file
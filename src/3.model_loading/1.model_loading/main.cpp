@@ -9,6 +9,8 @@
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+// vertex/index/texel bytes of streamed in models uploaded per frame
+const size_t UPLOAD_BUDGET_BYTES = 16 * 1024 * 1024;
 
 // camera
 Camera camera(glm::vec3(0.0f, 5.0f, 3.0f));
@@ -55,15 +57,22 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // the context is usually newer than the 3.3 asked for. Without GL 4.3 the scene draws every
+    // mesh on its own.
+    bool indirectDraw = loadIndirectDraw((GLADloadproc)glfwGetProcAddress);
+    std::cout << "multi draw indirect: " << (indirectDraw ? "on" : "unavailable") << std::endl;
 
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     // stbi_set_flip_vertically_on_load(true);
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLState& glState = GLState::global();
+    const DepthState depthLess{true, true, GL_LESS};
+    // the skybox passes the depth test where the depth buffer was only cleared
+    const DepthState depthLessEqual{true, true, GL_LEQUAL};
+    glState.setDepth(depthLess);
+    glState.setBlend({true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA});
 
     // build and compile shaders
     // -------------------------
@@ -76,9 +85,12 @@ int main() {
                         "src/3.model_loading/1.model_loading/6.2.skybox.fs");
 
     Mesh::loadDummyTextures();
-    // load models
+    // load models in the background, they show up as soon as they are uploaded
     // -----------
     Scene scene;
+    scene.SetIndirectDraw(indirectDraw);
+    // meshes smaller than a pixel or two are not worth a draw call
+    scene.SetMinPixelSize(2.0f);
     // scene.AddModel("resources/objects/cottage/cottage_obj.obj", glm::vec3{0, 0, -10},
     //                glm::vec3{0.4f}, 0, {"Cube_Cube.002"});
     // scene.AddModel("resources/objects/cottage2/Cottage_FREE.obj", glm::vec3{0, 0, 10},
@@ -88,9 +100,9 @@ int main() {
     // scene.AddModel("resources/objects/nanosuit/nanosuit.obj", glm::vec3{0, 0, 0},
     // glm::vec3{0.18},
     //                0);
-    scene.AddModel("resources/objects/seahawk/Seahawk.obj", glm::vec3{-15, 0, -5}, glm::vec3{0.1},
-                   0, {"Glass1"});
-    scene.AddModel("resources/objects/tree/Tree.obj", glm::vec3{-5, 0, 0}, glm::vec3{1}, 0);
+    scene.AddModelAsync("resources/objects/seahawk/Seahawk.obj", glm::vec3{-15, 0, -5},
+                        glm::vec3{0.1}, 0, {"Glass1"});
+    scene.AddModelAsync("resources/objects/tree/Tree.obj", glm::vec3{-5, 0, 0}, glm::vec3{1}, 0);
 
     // lighting
     std::vector<glm::vec3> pointLightPositions{
@@ -108,14 +120,58 @@ int main() {
 
     lightingShader.use();
     lightingShader.setInt("skybox", 5);
+    Mesh::setSamplerUnits(lightingShader);
+    lightingShader.setInt("draw_data", IndirectDrawList::DRAW_DATA_TEXTURE_UNIT);
+    lightingShader.setUniformBlockBinding("MaterialBlock", MATERIAL_BLOCK_BINDING);
+
+    // handles of the uniforms set every frame, so the loop neither builds names nor looks them up
+    struct LightUniforms {
+        Uniform position, direction, constant, linear, quadratic, cut_off, outer_cut_off,
+            ambient, diffuse, specular, enabled;
+    };
+    auto lightUniforms = [&](uint32_t prefix) {
+        auto member = [&](std::string_view name) {
+            return lightingShader.uniform(uniformHash(name, prefix));
+        };
+        LightUniforms uniforms;
+        uniforms.position = member("position");
+        uniforms.direction = member("direction");
+        uniforms.constant = member("constant");
+        uniforms.linear = member("linear");
+        uniforms.quadratic = member("quadratic");
+        uniforms.cut_off = member("cutOff");
+        uniforms.outer_cut_off = member("outerCutOff");
+        uniforms.ambient = member("ambient");
+        uniforms.diffuse = member("diffuse");
+        uniforms.specular = member("specular");
+        uniforms.enabled = member("enabled");
+        return uniforms;
+    };
+    const LightUniforms spotLightUniforms = lightUniforms(uniformHash("spotLight."));
+    const LightUniforms dirLightUniforms = lightUniforms(uniformHash("dirLight."));
+    std::vector<LightUniforms> pointLightUniforms;
+    for (unsigned int i = 0; i < pointLightPositions.size(); ++i) {
+        // "pointLights[i]."
+        pointLightUniforms.push_back(
+            lightUniforms(uniformHash("].", uniformHash(i, uniformHash("pointLights[")))));
+    }
+    const Uniform projectionUniform = lightingShader.uniform("projection");
+    const Uniform viewUniform = lightingShader.uniform("view");
+    const Uniform modelUniform = lightingShader.uniform("model");
+    const Uniform viewPosUniform = lightingShader.uniform("viewPos");
 
     // render loop
     // -----------
+    size_t frames = 0;
+    CullStats cullStats;
     while (!glfwWindowShouldClose(window)) {
         // input
         // -----
         processInput(window, &scale, &enable, &enable_flashlight);
 
+        // upload models that finished loading in the background
+        scene.Update(UPLOAD_BUDGET_BYTES);
+
         // draw in wireframe
         glPolygonMode(GL_FRONT_AND_BACK, enable ? GL_LINE : GL_FILL);
 
@@ -133,33 +189,35 @@ int main() {
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
                                                 (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
+        lightingShader.setMat4(projectionUniform, projection);
+        lightingShader.setMat4(viewUniform, view);
+        scene.SetView(camera.Position, projection * view, glm::radians(camera.Zoom),
+                      (float)SCR_HEIGHT);
 
-        lightingShader.setBool("spotLight.enabled", enable_flashlight);
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
+        lightingShader.setBool(spotLightUniforms.enabled, enable_flashlight);
+        lightingShader.setVec3(spotLightUniforms.position, camera.Position);
+        lightingShader.setVec3(spotLightUniforms.direction, camera.Front);
 
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09f);
-        lightingShader.setFloat("spotLight.quadratic", 0.032f);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+        lightingShader.setFloat(spotLightUniforms.constant, 1.0f);
+        lightingShader.setFloat(spotLightUniforms.linear, 0.09f);
+        lightingShader.setFloat(spotLightUniforms.quadratic, 0.032f);
+        lightingShader.setFloat(spotLightUniforms.cut_off, glm::cos(glm::radians(12.5f)));
+        lightingShader.setFloat(spotLightUniforms.outer_cut_off, glm::cos(glm::radians(17.5f)));
 
         glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
         glm::vec3 diffuseColor = lightColor * glm::vec3(0.5f);
         glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
 
-        lightingShader.setVec3("spotLight.ambient", ambientColor);
-        lightingShader.setVec3("spotLight.diffuse", diffuseColor);
-        lightingShader.setVec3("spotLight.specular", lightColor);
+        lightingShader.setVec3(spotLightUniforms.ambient, ambientColor);
+        lightingShader.setVec3(spotLightUniforms.diffuse, diffuseColor);
+        lightingShader.setVec3(spotLightUniforms.specular, lightColor);
 
-        lightingShader.setVec3("viewPos", camera.Position);
+        lightingShader.setVec3(viewPosUniform, camera.Position);
 
-        lightingShader.setVec3("dirLight.direction", 0.2f, -0.1f, 0.3f);
-        lightingShader.setVec3("dirLight.ambient", glm::vec3(0.1));
-        lightingShader.setVec3("dirLight.diffuse", glm::vec3(0.4));
-        lightingShader.setVec3("dirLight.specular", glm::vec3(1.0));
+        lightingShader.setVec3(dirLightUniforms.direction, 0.2f, -0.1f, 0.3f);
+        lightingShader.setVec3(dirLightUniforms.ambient, glm::vec3(0.1));
+        lightingShader.setVec3(dirLightUniforms.diffuse, glm::vec3(0.4));
+        lightingShader.setVec3(dirLightUniforms.specular, glm::vec3(1.0));
 
         std::vector<glm::vec3> lightColors(pointLightPositions.size());
         lightColors.at(0) = glm::vec3{1.0, 1.0, 0.0};
@@ -179,38 +237,32 @@ int main() {
             // pointLightPositions[i].y = (1 + std::cos((float)glfwGetTime() / (1))) * (i + 5);
             // pointLightPositions[i].z = std::cos((float)glfwGetTime() * (1) + 90 * i) * (i + 15);
 
-            std::string name = "pointLights[";
-            name.append(std::to_string(i)).append("].");
+            const LightUniforms& uniforms = pointLightUniforms[i];
+            lightingShader.setVec3(uniforms.position, pointLightPositions[i]);
 
-            lightingShader.setVec3(name + "position", pointLightPositions[i]);
+            lightingShader.setFloat(uniforms.constant, 1.0f);
+            lightingShader.setFloat(uniforms.linear, 0.09f);
+            lightingShader.setFloat(uniforms.quadratic, 0.032f);
 
-            lightingShader.setFloat(name + "constant", 1.0f);
-            lightingShader.setFloat(name + "linear", 0.09f);
-            lightingShader.setFloat(name + "quadratic", 0.032f);
-
-            lightingShader.setVec3(name + "ambient", ambientColor);
-            lightingShader.setVec3(name + "diffuse", diffuseColor);
-            lightingShader.setVec3(name + "specular", lightColors[i]);
+            lightingShader.setVec3(uniforms.ambient, ambientColor);
+            lightingShader.setVec3(uniforms.diffuse, diffuseColor);
+            lightingShader.setVec3(uniforms.specular, lightColors[i]);
         }
 
         {
-            glActiveTexture(GL_TEXTURE0);
-            lightingShader.setInt("material.texture_diffuse1", 0);
-            glBindTexture(GL_TEXTURE_2D, Mesh::dummy_textures.at("texture_diffuse").id);
-            glActiveTexture(GL_TEXTURE1);
-            lightingShader.setInt("material.texture_specular1", 1);
-            glBindTexture(GL_TEXTURE_2D, Mesh::dummy_textures.at("texture_specular").id);
-            glActiveTexture(GL_TEXTURE2);
-            lightingShader.setInt("material.texture_reflection1", 2);
-            glBindTexture(GL_TEXTURE_2D, Mesh::dummy_textures.at("texture_reflection").id);
+            // the ground samples the dummy textures; its block in DrawGround keeps the layers -1
+            for (TextureRole role :
+                 {TextureRole::Diffuse, TextureRole::Specular, TextureRole::Reflection}) {
+                glState.bindTexture(Mesh::textureUnit(role), GL_TEXTURE_2D,
+                                    Mesh::dummyTexture(role).id);
+            }
             auto model = glm::mat4(1.0f);
             model = glm::scale(model, glm::vec3(20.0, 1.0, 20.0));
-            lightingShader.setMat4("model", model);
+            lightingShader.setMat4(modelUniform, model);
             DrawGround(lightingShader);
         }
 
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        glState.bindTexture(5, GL_TEXTURE_CUBE_MAP, cubemapTexture);
         scene.Render(lightingShader);
 
         // also draw the lamp object
@@ -229,15 +281,15 @@ int main() {
         lightingShader.use();
         scene.RenderTransparent(lightingShader);
 
-        glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal
-        // to depth buffer's content
+        glState.setDepth(depthLessEqual);
         skyboxShader.use();
         skyboxShader.setMat4("view", glm::mat4(glm::mat3(view)));
         skyboxShader.setMat4("projection", projection);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+        glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
         DrawSkybox(skyboxShader);
-        glDepthFunc(GL_LESS);  // set depth function back to default
+        glState.setDepth(depthLess);
+        cullStats += scene.GetCullStats();
+        ++frames;
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -245,6 +297,18 @@ int main() {
         glfwPollEvents();
     }
 
+    if (frames > 0) {
+        std::cout << "GL state calls per frame: " << glState.stats().issued / frames
+                  << " issued, " << glState.stats().elided / frames << " elided" << std::endl;
+        std::cout << "meshes per frame: " << cullStats.tested / frames << " tested, "
+                  << cullStats.outside / frames << " outside the frustum, "
+                  << cullStats.too_small / frames << " too small, "
+                  << cullStats.nodes / frames << " BVH nodes tested" << std::endl;
+    }
+
+    // the textures are deleted while there still is a context
+    scene.Clear();
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -265,7 +329,7 @@ void DrawGround(Shader& shader) {
     if (lightCubeVAO == 0) {
         glGenVertexArrays(1, &lightCubeVAO);
         glGenBuffers(1, &VBO);
-        glBindVertexArray(lightCubeVAO);
+        GLState::global().bindVertexArray(lightCubeVAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
         // position attribute
@@ -279,18 +343,20 @@ void DrawGround(Shader& shader) {
         glEnableVertexAttribArray(0);
     }
 
-    glm::vec3 lightColor(0.8f, 1.0f, 0.8f);
-    glm::vec3 diffuseColor = lightColor * glm::vec3(0.99f);
-    glm::vec3 ambientColor = diffuseColor * glm::vec3(0.9f);
-    shader.setVec3("material.color_ambient", ambientColor);
-    shader.setVec3("material.color_diffuse", diffuseColor);
-    shader.setVec3("material.color_specular", lightColor);
-    shader.setFloat("material.shininess", 128);
-    shader.setFloat("material.dissolve", 1.0);
+    static size_t materialOffset = SIZE_MAX;
+    if (materialOffset == SIZE_MAX) {
+        MaterialBlock material;
+        material.color_specular = glm::vec3(0.8f, 1.0f, 0.8f);
+        material.color_diffuse = material.color_specular * glm::vec3(0.99f);
+        material.color_ambient = material.color_diffuse * glm::vec3(0.9f);
+        material.shininess = 128;
+        material.dissolve = 1.0;
+        materialOffset = MaterialBuffer::global().add(material);
+    }
+    MaterialBuffer::global().bind(materialOffset);
 
-    glBindVertexArray(lightCubeVAO);
+    GLState::global().bindVertexArray(lightCubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
 
 void DrawLightCube(Shader& shader) {
@@ -331,16 +397,15 @@ void DrawLightCube(Shader& shader) {
     if (lightCubeVAO == 0) {
         glGenVertexArrays(1, &lightCubeVAO);
         glGenBuffers(1, &VBO);
-        glBindVertexArray(lightCubeVAO);
+        GLState::global().bindVertexArray(lightCubeVAO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         // position attribute
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
     }
-    glBindVertexArray(lightCubeVAO);
+    GLState::global().bindVertexArray(lightCubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
 
 void DrawSkybox(Shader& shader) {
@@ -367,7 +432,7 @@ void DrawSkybox(Shader& shader) {
     if (skyboxVAO == 0) {
         glGenVertexArrays(1, &skyboxVAO);
         glGenBuffers(1, &skyboxVBO);
-        glBindVertexArray(skyboxVAO);
+        GLState::global().bindVertexArray(skyboxVAO);
         glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -375,7 +440,6 @@ void DrawSkybox(Shader& shader) {
     }
 
     // skybox cube
-    glBindVertexArray(skyboxVAO);
+    GLState::global().bindVertexArray(skyboxVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
 }
\ No newline at end of file
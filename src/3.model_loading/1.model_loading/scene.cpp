@@ -1,37 +1,265 @@
 #include "scene.h"
 
+static constexpr uint32_t MODEL_UNIFORM = uniformHash("model");
+
+ModelLoadOptions Scene::defaultLoadOptions() {
+    ModelLoadOptions options;
+    options.max_lods = 4;
+    options.build_meshlets = true;
+    // meshes with same sized textures are drawn without binding textures in between
+    options.texture_arrays = true;
+    // all models of the scene share one VAO per vertex layout
+    options.geometry_buffer = std::make_shared<GeometryBuffer>();
+    return options;
+}
+
+void Scene::SetLoadOptions(const ModelLoadOptions& options) {
+    std::shared_ptr<GeometryBuffer> geometry_buffer = load_options.geometry_buffer;
+    load_options = options;
+    if (!load_options.geometry_buffer) load_options.geometry_buffer = geometry_buffer;
+}
+
+ModelLoadOptions Scene::loadOptions(std::optional<ImportPreset> preset) const {
+    ModelLoadOptions options = load_options;
+    if (preset) options.import_preset = *preset;
+    return options;
+}
+
 void Scene::AddModel(const std::string& file_name, glm::vec3 pos, glm::vec3 scale, float angle,
-                     const std::vector<std::string>& mesh_names) {
+                     const std::vector<std::string>& mesh_names,
+                     std::optional<ImportPreset> preset) {
     if (models.count(file_name) == 0) {
-        models.emplace(std::make_pair(file_name, Model(file_name, mesh_names)));
+        models.try_emplace(file_name, file_name, mesh_names, false, loadOptions(preset));
     }
 
-    for (const auto& mesh : models.at(file_name).meshes) {
-        if (mesh.isTransparent()) {
-            render_meshes_transparent.push_back(RenderMesh{&mesh, pos, scale, angle});
+    AddRenderMeshes(file_name, Placement{pos, scale, angle});
+}
+
+std::shared_future<void> Scene::AddModelAsync(const std::string& file_name, glm::vec3 pos,
+                                              glm::vec3 scale, float angle,
+                                              const std::vector<std::string>& mesh_names,
+                                              std::optional<ImportPreset> preset) {
+    if (models.count(file_name) != 0) {
+        AddRenderMeshes(file_name, Placement{pos, scale, angle});
+        std::promise<void> added;
+        added.set_value();
+        return added.get_future().share();
+    }
+
+    auto iter = pending_models.find(file_name);
+    if (iter == pending_models.end()) {
+        iter = pending_models.emplace(file_name, PendingModel{}).first;
+        iter->second.handle = loader.load(file_name, mesh_names, loadOptions(preset));
+        iter->second.future = iter->second.added.get_future().share();
+    }
+    iter->second.placements.push_back(Placement{pos, scale, angle});
+    return iter->second.future;
+}
+
+void Scene::Update(size_t upload_budget_bytes) {
+    if (loader.isIdle()) return;
+
+    for (const auto& handle : loader.processUploads(upload_budget_bytes)) {
+        auto iter = pending_models.find(handle->path());
+        if (iter == pending_models.end()) continue;
+        PendingModel& pending = iter->second;
+
+        if (handle->isFailed()) {
+            pending.added.set_exception(
+                std::make_exception_ptr(std::runtime_error(handle->error())));
         } else {
-            render_meshes.push_back(RenderMesh{&mesh, pos, scale, angle});
+            // a synchronous AddModel of the same file may have finished first
+            if (models.count(handle->path()) == 0) {
+                models.emplace(handle->path(), handle->takeModel());
+                std::cout << handle->path() << ": CPU geometry resident after upload: "
+                          << models.at(handle->path()).residentBytes() << " bytes\n";
+            }
+            for (const auto& placement : pending.placements) {
+                AddRenderMeshes(handle->path(), placement);
+            }
+            pending.added.set_value();
         }
+        pending_models.erase(iter);
     }
 }
 
-void Scene::Render(Shader& shader) {
-    for (const auto& mesh : render_meshes) {
-        DrawMesh(shader, mesh);
+void Scene::AddRenderMeshes(const std::string& file_name, const Placement& placement) {
+    std::vector<PlacedMesh>& placed = placed_meshes[file_name].emplace_back();
+    for (const auto& mesh : models.at(file_name).meshes) {
+        RenderMesh render_mesh{&mesh, placement.pos, placement.scale, placement.angle};
+        RenderList& list = mesh.isTransparent() ? render_meshes_transparent : render_meshes;
+        placed.push_back(
+            PlacedMesh{mesh.isTransparent(), static_cast<uint32_t>(list.meshes.size())});
+        list.add(render_mesh);
     }
 }
 
+void Scene::MovePlacement(const std::string& file_name, size_t placement, glm::vec3 pos,
+                          glm::vec3 scale, float angle) {
+    for (const auto& placed : placed_meshes.at(file_name).at(placement)) {
+        RenderList& list = placed.transparent ? render_meshes_transparent : render_meshes;
+        list.move(placed.index, Placement{pos, scale, angle});
+    }
+}
+
+void Scene::Clear() {
+    render_meshes = RenderList();
+    render_meshes_transparent = RenderList();
+    placed_meshes.clear();
+    // the models release their textures, the cache only deletes them when asked to
+    models.clear();
+    TextureCache::global().purge();
+    // the allocations of the unloaded models are never freed, so the scene starts over with an
+    // empty buffer. Models still loading keep it in use until a later Clear.
+    const std::shared_ptr<GeometryBuffer>& geometry_buffer = load_options.geometry_buffer;
+    if (geometry_buffer && geometry_buffer.use_count() == 1) geometry_buffer->release();
+}
+
+void Scene::RenderList::move(uint32_t index, const Placement& placement) {
+    RenderMesh& mesh = meshes[index];
+    mesh.SetTransform(placement.pos, placement.scale, placement.angle);
+    // an outdated BVH is built from the new bounds anyway
+    if (!bvh_outdated) bvh.update(index, mesh.world_bounds);
+}
+
+CullStats Scene::RenderList::cull(const Frustum& frustum, const glm::vec3& camera_pos,
+                                  float projection_scale, float min_pixels,
+                                  std::vector<uint32_t>& visible) {
+    if (bvh_outdated) {
+        std::vector<Bounds> bounds;
+        bounds.reserve(meshes.size());
+        for (const auto& mesh : meshes) bounds.push_back(mesh.world_bounds);
+        bvh.build(bounds);
+        bvh_outdated = false;
+    }
+
+    // the BVH finds the leaves in the frustum, then their meshes are tested one by one
+    leaves.clear();
+    size_t nodes = bvh.query(frustum, leaves);
+    size_t first_visible = visible.size();
+    CullStats stats = cullBounds(frustum, bvh.leafBounds(), leaves, camera_pos, projection_scale,
+                                 min_pixels, visible);
+    for (size_t i = first_visible; i < visible.size(); ++i) visible[i] = bvh.object(visible[i]);
+    stats.nodes = nodes;
+    // the meshes of the leaves outside of the frustum
+    stats.outside += meshes.size() - stats.tested;
+    return stats;
+}
+
+void Scene::SetView(const glm::vec3& camera_pos, const glm::mat4& view_projection, float fov_y,
+                    float viewport_height) {
+    this->camera_pos = camera_pos;
+    this->view_projection = view_projection;
+    view_frustum = Frustum(view_projection);
+    projection_scale = viewport_height / (2.0f * std::tan(fov_y / 2.0f));
+    cull_stats = CullStats();
+}
+
+void Scene::Render(Shader& shader) {
+    RenderPass(shader, render_meshes, RenderQueue::Pass::Opaque);
+}
+
 void Scene::RenderTransparent(Shader& shader) {
-    for (const auto& mesh : render_meshes_transparent) {
-        DrawMesh(shader, mesh);
+    RenderPass(shader, render_meshes_transparent, RenderQueue::Pass::Transparent);
+}
+
+void Scene::RenderPass(Shader& shader, RenderList& list, RenderQueue::Pass pass) {
+    std::vector<RenderMesh>& meshes = list.meshes;
+    visible_meshes.clear();
+    if (projection_scale > 0.0f) {
+        // the world space bounds are tested against the view frustum without transforming
+        // anything
+        cull_stats +=
+            list.cull(view_frustum, camera_pos, projection_scale, min_pixel_size, visible_meshes);
+    } else {
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            visible_meshes.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    render_queue.clear();
+    for (uint32_t i : visible_meshes) {
+        RenderMesh& mesh = meshes[i];
+        SelectLod(mesh);
+        float depth = glm::length(mesh.world_bounds.center - camera_pos);
+        render_queue.push(RenderQueue::makeKey(pass, shader.ID, mesh.mesh->getTextureKey(),
+                                               mesh.mesh->getVAO(), depth),
+                          i);
+    }
+    // opaque meshes are grouped by state and drawn front to back within a group, transparent
+    // ones are drawn back to front
+    render_queue.sort();
+    if (indirect_draw && hasIndirectDraw()) {
+        // consecutive packets sharing VAO and textures become one glMultiDrawElementsIndirect
+        indirect_draws.clear();
+        for (const auto& packet : render_queue.getPackets()) {
+            AddIndirectDraw(meshes[packet.index]);
+        }
+        indirect_draws.submit(shader);
+        return;
+    }
+    for (const auto& packet : render_queue.getPackets()) {
+        DrawMesh(shader, meshes[packet.index]);
     }
 }
 
+void Scene::GetVisibleMeshes(const Frustum& frustum, std::vector<const RenderMesh*>& visible) {
+    for (RenderList* list : {&render_meshes, &render_meshes_transparent}) {
+        visible_meshes.clear();
+        list->cull(frustum, camera_pos, projection_scale, 0.0f, visible_meshes);
+        for (uint32_t i : visible_meshes) visible.push_back(&list->meshes[i]);
+    }
+}
+
+void Scene::SelectLod(RenderMesh& mesh) const {
+    size_t num_lods = mesh.mesh->getNumLods();
+    if (num_lods < 2 || projection_scale <= 0.0f) {
+        mesh.lod = 0;
+        return;
+    }
+
+    const glm::vec3& center = mesh.world_bounds.center;
+    float radius = mesh.world_bounds.radius;
+
+    // LOD errors are relative to the mesh extent, which is at most the sphere diameter
+    float distance = std::max(glm::length(center - camera_pos) - radius, 0.01f);
+    float pixels_per_error = 2.0f * radius * projection_scale / distance;
+    auto pixelError = [&](size_t lod) { return mesh.mesh->getLod(lod).error * pixels_per_error; };
+
+    size_t lod = std::min(mesh.lod, num_lods - 1);
+    while (lod > 0 && pixelError(lod) > lod_settings.pixel_error) --lod;
+    while (lod + 1 < num_lods &&
+           pixelError(lod + 1) <= lod_settings.pixel_error * (1.0f - lod_settings.hysteresis)) {
+        ++lod;
+    }
+    mesh.lod = lod;
+}
+
+bool Scene::UsesMeshlets(const RenderMesh& mesh) const {
+    return projection_scale > 0.0f && mesh.lod == 0 && !mesh.mesh->getMeshlets().empty();
+}
+
 void Scene::DrawMesh(Shader& shader, const RenderMesh& mesh) {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, mesh.pos);
-    model = glm::scale(model, mesh.scale);
-    model = glm::rotate(model, glm::radians(mesh.angle), glm::vec3(0.0f, 1.0f, 0.0f));
-    shader.setMat4("model", model);
-    mesh.Draw(shader);
+    shader.setMat4(shader.uniform(MODEL_UNIFORM), mesh.model_matrix);
+    if (UsesMeshlets(mesh)) {
+        // the planes of the frustum of projection * view * model are in model space, so the
+        // meshlets are tested without transforming them
+        Frustum frustum(view_projection * mesh.model_matrix);
+        glm::vec3 camera_pos_model = glm::inverse(mesh.model_matrix) * glm::vec4(camera_pos, 1.0f);
+        mesh.mesh->DrawMeshlets(frustum, camera_pos_model, backface_culling);
+    } else {
+        mesh.Draw(shader);
+    }
+}
+
+void Scene::AddIndirectDraw(const RenderMesh& mesh) {
+    if (!UsesMeshlets(mesh)) {
+        indirect_draws.add(*mesh.mesh, mesh.lod, mesh.model_matrix);
+        return;
+    }
+    meshlet_ranges.clear();
+    Frustum frustum(view_projection * mesh.model_matrix);
+    glm::vec3 camera_pos_model = glm::inverse(mesh.model_matrix) * glm::vec4(camera_pos, 1.0f);
+    mesh.mesh->visibleMeshlets(frustum, camera_pos_model, backface_culling, meshlet_ranges);
+    indirect_draws.add(*mesh.mesh, meshlet_ranges, mesh.model_matrix);
 }
\ No newline at end of file
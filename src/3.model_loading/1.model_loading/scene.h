@@ -1,34 +1,192 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <future>
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 
+#include "learnopengl/bvh.h"
+#include "learnopengl/cull.h"
+#include "learnopengl/indirect_draw.h"
 #include "learnopengl/model.h"
+#include "learnopengl/model_loader.h"
+#include "learnopengl/render_queue.h"
+#include "learnopengl/texture_cache.h"
 
 struct RenderMesh {
     const Mesh *mesh = nullptr;
     glm::vec3 pos;
     glm::vec3 scale;
     float angle;
+    // model matrix and world space bounds of the placement, updated by SetTransform
+    glm::mat4 model_matrix = glm::mat4(1.0f);
+    Bounds world_bounds;
+    // level of detail drawn, updated by Scene::Render
+    size_t lod = 0;
 
-    void Draw(Shader &shader) const { mesh->Draw(shader); }
+    RenderMesh(const Mesh *mesh, const glm::vec3 &pos, const glm::vec3 &scale, float angle)
+        : mesh(mesh) {
+        SetTransform(pos, scale, angle);
+    }
+
+    // moves the mesh, angle is the rotation around y in degrees
+    void SetTransform(const glm::vec3 &new_pos, const glm::vec3 &new_scale, float new_angle) {
+        pos = new_pos;
+        scale = new_scale;
+        angle = new_angle;
+        model_matrix = glm::translate(glm::mat4(1.0f), pos);
+        model_matrix = glm::scale(model_matrix, scale);
+        model_matrix = glm::rotate(model_matrix, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+        world_bounds = mesh->getBounds().transformed(model_matrix);
+    }
+
+    void Draw(Shader &shader) const { mesh->Draw(shader, lod); }
+};
+
+// how Scene picks the level of detail of a mesh
+struct LodSettings {
+    // the coarsest LOD whose error projects to at most this many pixels is drawn
+    float pixel_error = 1.0f;
+    // a coarser LOD is only picked when its error is below pixel_error * (1 - hysteresis), so
+    // meshes near the threshold don't keep switching between two LODs
+    float hysteresis = 0.25f;
 };
 
 class Scene {
    public:
+    // preset overrides the import preset of the load options for this model. A file is only
+    // loaded once, adding it again places the already loaded model whatever the preset.
     void AddModel(const std::string &file_name, glm::vec3 pos, glm::vec3 scale, float angle,
-                  const std::vector<std::string> &mesh_names = {});
+                  const std::vector<std::string> &mesh_names = {},
+                  std::optional<ImportPreset> preset = std::nullopt);
+    // same as AddModel, but loads the model in the background and returns immediately. The model
+    // is not rendered until Update() has uploaded it, the returned future becomes ready then.
+    std::shared_future<void> AddModelAsync(const std::string &file_name, glm::vec3 pos,
+                                           glm::vec3 scale, float angle,
+                                           const std::vector<std::string> &mesh_names = {},
+                                           std::optional<ImportPreset> preset = std::nullopt);
+
+    // uploads models loaded in the background, at most upload_budget_bytes per call. Call once
+    // per frame.
+    void Update(size_t upload_budget_bytes);
+    // moves the placement-th placement of file_name, counting in the order the placements
+    // started rendering. Throws std::out_of_range if there is no such placement yet.
+    void MovePlacement(const std::string &file_name, size_t placement, glm::vec3 pos,
+                       glm::vec3 scale, float angle);
+    // unloads every model, deletes the textures no other model uses anymore and empties the
+    // geometry buffer of the scene unless something else still holds it. Models still loading in
+    // the background are placed once they finished. Must be called on the GL thread while the
+    // context is current.
+    void Clear();
+
+    // camera used for culling and LOD selection. fov_y is the vertical field of view of
+    // view_projection in radians and viewport_height the height of the viewport in pixels.
+    // Resets the cull stats, so call once per frame.
+    void SetView(const glm::vec3 &camera_pos, const glm::mat4 &view_projection, float fov_y,
+                 float viewport_height);
+    // meshes whose bounding sphere projects to fewer pixels across are not drawn, 0 draws all
+    // meshes in the frustum
+    void SetMinPixelSize(float pixels) { min_pixel_size = pixels; }
+    // meshes tested and culled by the Render and RenderTransparent calls since SetView
+    const CullStats &GetCullStats() const { return cull_stats; }
+    // appends the meshes, opaque and transparent, whose bounds intersect frustum, for views
+    // other than the camera such as shadow maps and reflections
+    void GetVisibleMeshes(const Frustum &frustum, std::vector<const RenderMesh *> &visible);
+    void SetLodSettings(const LodSettings &settings) { lod_settings = settings; }
+    // skip meshlets facing away from the camera, only correct while GL_CULL_FACE is enabled
+    void SetBackfaceCulling(bool enable) { backface_culling = enable; }
+    // draw each pass with glMultiDrawElementsIndirect, one call per bucket of meshes sharing
+    // VAO and textures. Only has an effect if hasIndirectDraw(), the shader must take the model
+    // matrices and materials from draw_data (see IndirectDrawList).
+    void SetIndirectDraw(bool enable) { indirect_draw = enable; }
+    // options models are loaded with, only affects models added afterwards. Unless options name
+    // a geometry buffer, the models keep sharing the one of the scene.
+    void SetLoadOptions(const ModelLoadOptions &options);
 
     void Render(Shader &shader);
     void RenderTransparent(Shader &shader);
 
    private:
+    struct Placement {
+        glm::vec3 pos;
+        glm::vec3 scale;
+        float angle;
+    };
+
+    // a model that is still being loaded by the loader
+    struct PendingModel {
+        std::shared_ptr<ModelHandle> handle;
+        std::promise<void> added;
+        std::shared_future<void> future;
+        std::vector<Placement> placements;
+    };
+
+    // the meshes of one pass and a BVH over their world space bounds. The BVH is refit as
+    // meshes move and built again once meshes were added.
+    struct RenderList {
+        std::vector<RenderMesh> meshes;
+        Bvh bvh;
+        bool bvh_outdated = false;
+        // the leaves of the BVH in the frustum, kept to not allocate every frame
+        std::vector<BoundsRange> leaves;
+
+        void add(const RenderMesh &mesh) {
+            meshes.push_back(mesh);
+            bvh_outdated = true;
+        }
+        void move(uint32_t index, const Placement &placement);
+        // appends the indices of the meshes that intersect frustum and cover min_pixels
+        CullStats cull(const Frustum &frustum, const glm::vec3 &camera_pos,
+                       float projection_scale, float min_pixels, std::vector<uint32_t> &visible);
+    };
+
+    // a mesh of a placement, in render_meshes or render_meshes_transparent
+    struct PlacedMesh {
+        bool transparent;
+        uint32_t index;
+    };
+
+    void AddRenderMeshes(const std::string &file_name, const Placement &placement);
+    // draws the visible meshes in the order of their RenderQueue keys
+    void RenderPass(Shader &shader, RenderList &list, RenderQueue::Pass pass);
     void DrawMesh(Shader &shader, const RenderMesh &mesh);
+    // adds mesh to indirect_draws, culling its meshlets like DrawMesh
+    void AddIndirectDraw(const RenderMesh &mesh);
+    // whether mesh is drawn by its visible meshlets
+    bool UsesMeshlets(const RenderMesh &mesh) const;
+    void SelectLod(RenderMesh &mesh) const;
+    // models are loaded with LODs into one geometry buffer unless SetLoadOptions says otherwise
+    static ModelLoadOptions defaultLoadOptions();
+    // load_options with the import preset replaced by preset if there is one
+    ModelLoadOptions loadOptions(std::optional<ImportPreset> preset) const;
+
+    ModelLoadOptions load_options = defaultLoadOptions();
+    LodSettings lod_settings;
+    bool backface_culling = false;
+    bool indirect_draw = false;
+    glm::vec3 camera_pos = glm::vec3(0.0f);
+    glm::mat4 view_projection = glm::mat4(1.0f);
+    // frustum of view_projection in world space
+    Frustum view_frustum;
+    // pixels per world unit at distance 1, 0 until SetView is called
+    float projection_scale = 0.0f;
+    float min_pixel_size = 0.0f;
+    CullStats cull_stats;
 
+    ModelLoader loader;
+    std::unordered_map<std::string, PendingModel> pending_models;
     std::unordered_map<std::string, Model> models;
-    std::vector<RenderMesh> render_meshes;
-    std::vector<RenderMesh> render_meshes_transparent;
+    RenderList render_meshes;
+    RenderList render_meshes_transparent;
+    // the meshes of every placement of every model
+    std::unordered_map<std::string, std::vector<std::vector<PlacedMesh>>> placed_meshes;
+    // the visible meshes and draws of the pass being rendered, kept to not allocate every frame
+    std::vector<uint32_t> visible_meshes;
+    std::vector<IndexRange> meshlet_ranges;
+    RenderQueue render_queue;
+    IndirectDrawList indirect_draws;
 };
 
 #endif
\ No newline at end of file
@@ -112,7 +112,7 @@ int main() {
     // -----------------------------------------------------------------------------------------------------------------------------------
     for (unsigned int i = 0; i < rock.meshes.size(); i++) {
         unsigned int VAO = rock.meshes[i].getVAO();
-        glBindVertexArray(VAO);
+        GLState::global().bindVertexArray(VAO);
         // set attribute pointers for matrix (4 times vec4)
         glEnableVertexAttribArray(3);
         glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
@@ -130,9 +130,8 @@ int main() {
         glVertexAttribDivisor(4, 1);
         glVertexAttribDivisor(5, 1);
         glVertexAttribDivisor(6, 1);
-
-        glBindVertexArray(0);
     }
+    GLState::global().bindVertexArray(0);
 
     // render loop
     // -----------
@@ -167,17 +166,17 @@ int main() {
         // draw meteorites
         asteroidShader.use();
         asteroidShader.setInt("texture_diffuse1", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(
-            GL_TEXTURE_2D,
+        GLState::global().bindTexture(
+            0, GL_TEXTURE_2D,
             rock.textures_loaded[0].id);  // note: we also made the textures_loaded vector public
                                           // (instead of private) from the model class.
         for (unsigned int i = 0; i < rock.meshes.size(); i++) {
-            glBindVertexArray(rock.meshes[i].getVAO());
-            glDrawElementsInstanced(GL_TRIANGLES,
-                                    static_cast<unsigned int>(rock.meshes[i].getindices().size()),
-                                    GL_UNSIGNED_INT, 0, amount);
-            glBindVertexArray(0);
+            // the meshes of a model live in shared buffers, at their own offsets
+            GLState::global().bindVertexArray(rock.meshes[i].getVAO());
+            glDrawElementsInstancedBaseVertex(
+                GL_TRIANGLES, static_cast<GLsizei>(rock.meshes[i].getNumIndices()),
+                rock.meshes[i].getIndexType(), (void*)rock.meshes[i].getIndexOffset(), amount,
+                rock.meshes[i].getBaseVertex());
         }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
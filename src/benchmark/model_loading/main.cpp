@@ -0,0 +1,621 @@
+#define GLFW_INCLUDE_NONE
+#define STB_IMAGE_IMPLEMENTATION
+#include <GLFW/glfw3.h>
+#include <fcntl.h>
+#include <glad/glad.h>
+#include <learnopengl/bvh.h>
+#include <learnopengl/indirect_draw.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/model.h>
+#include <learnopengl/texture_cache.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Times the phases of loading every model in resources/objects:
+//   read     reading the model file from disk
+//   import   Assimp or OBJ parser import, or mapping the mesh cache
+//   convert  processMesh and the optimizer, LOD and meshlet passes
+//   cache    writing the mesh cache
+//   decode   decoding the textures
+//   upload   uploading meshes and textures to GL, until glFinish returns
+//
+// Every model is loaded with each requested import preset, and the vertex/index counts are
+// reported next to the times, to weigh import time against the size of the result. Cold runs
+// delete the mesh cache and drop the model directory from the page cache first, warm runs load
+// again with both in place. The texture cache is purged between runs, so every run
+// decodes and uploads its textures.
+//
+// The GL context belongs to a hidden GLFW window, so on a headless box the benchmark runs under
+// a virtual X server with Mesa's software rasterizer:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./model_loading_benchmark --csv results.csv
+// Without a context (or with --no-gl) the upload phase is skipped.
+//
+// With --draw N, every model is then drawn as N copies for a few frames, once with a draw call
+// per mesh and once with IndirectDrawList, and the CPU time of submitting a frame is reported
+// for both. The GL context is usually newer than the 3.3 asked for, Mesa's llvmpipe gives 4.5.
+// The draws use the shaders of the model loading demo.
+//
+// With --cull N, the meshes of every model are placed N times at random over a square and culled
+// for a camera at its edge, with the Bvh the scene uses and with a flat cullBounds over all of
+// them. The build, a refit of 1% of the placements and both culls are timed on the CPU, no GL
+// needed.
+//
+// options:
+//   --runs N         runs per model and mode (default 3)
+//   --models a,b     directories in resources/objects to load (default: all)
+//   --presets a,b    import presets to load with: fast-preview, runtime-optimized, exact
+//                    (default: exact)
+//   --assimp         import OBJ files with Assimp as well instead of the built-in parser
+//   --csv FILE       write every run as CSV
+//   --json FILE      write every run as JSON
+//   --baseline FILE  compare the median total time per model and mode with a CSV written by
+//                    --csv and exit with 1 if one got slower than the tolerance allows, has
+//                    no times in the baseline, or the baseline can't be read
+//   --tolerance X    allowed slowdown over the baseline (default 0.25, i.e. 25%)
+//   --no-gl          don't create a GL context, skip the upload
+//   --draw N         time submitting N copies of each model per frame, see above
+//   --cull N         time culling N copies of each model, see above
+
+const char *OBJECTS_DIRECTORY = "resources/objects";
+const std::vector<std::string> DEFAULT_MODELS = {"cottage", "cottage2", "tower",
+                                                 "nanosuit", "seahawk",  "tree",
+                                                 "rock",    "planet",   "backpack"};
+const std::vector<std::string> MODEL_EXTENSIONS = {".obj", ".fbx", ".dae", ".gltf",
+                                                   ".glb", ".3ds", ".blend"};
+
+struct RunResult {
+    std::string model;
+    std::string preset;
+    std::string mode;
+    int run = 0;
+    double read_ms = 0;
+    ModelLoadTimings timings;
+    double upload_ms = 0;
+    size_t meshes = 0;
+    size_t vertices = 0;
+    size_t indices = 0;
+
+    // runs are grouped by model, preset and mode
+    std::string key() const { return model + '/' + preset + '/' + mode; }
+
+    double total() const {
+        return read_ms + timings.import_ms + timings.convert_ms + timings.cache_write_ms +
+               timings.decode_ms + upload_ms;
+    }
+};
+
+// CPU time of submitting one frame of a model, as the median over DRAW_FRAMES frames
+struct DrawResult {
+    std::string model;
+    size_t draws = 0;
+    double direct_ms = 0;
+    double indirect_ms = 0;
+    // glMultiDrawElementsIndirect calls of an indirect frame
+    size_t indirect_calls = 0;
+};
+
+const int DRAW_FRAMES = 20;
+
+// CPU times of culling the placed meshes of a model
+struct CullResult {
+    std::string model;
+    size_t objects = 0;
+    size_t visible = 0;
+    double build_ms = 0;
+    double refit_ms = 0;
+    // medians over DRAW_FRAMES frames
+    double bvh_ms = 0;
+    double flat_ms = 0;
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// the model file in a directory of resources/objects, empty if there is none
+static std::string findModelFile(const std::string &name) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> candidates;
+    std::error_code error;
+    for (const auto &entry : fs::directory_iterator(fs::path(OBJECTS_DIRECTORY) / name, error)) {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (std::find(MODEL_EXTENSIONS.begin(), MODEL_EXTENSIONS.end(), extension) !=
+            MODEL_EXTENSIONS.end()) {
+            candidates.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    return candidates.empty() ? std::string() : candidates.front();
+}
+
+// drops the files of a directory from the page cache, so the next read goes to the disk. Only
+// clean pages are dropped, which is all of them for files that are only read.
+static void evictDirectory(const std::string &directory) {
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file()) continue;
+        int fd = open(entry.path().c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static RunResult runOnce(const std::string &name, const std::string &path,
+                         const ModelLoadOptions &options, bool cold, int run, bool gl) {
+    RunResult result;
+    result.model = name;
+    result.preset = importPresetName(options.import_preset);
+    result.mode = cold ? "cold" : "warm";
+    result.run = run;
+
+    if (cold) {
+        std::filesystem::remove(MeshCache::cachePath(path));
+        evictDirectory(path.substr(0, path.find_last_of('/')));
+    }
+
+    // the file is read once on its own, so the import phase measures parsing without the disk
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<char> buffer(1 << 20);
+        while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        }
+    }
+    result.read_ms = millisecondsSince(start);
+
+    ModelData data = Model::loadData(path, {}, options, true);
+    result.timings = data.timings;
+    result.meshes = data.meshes.size();
+    result.vertices = data.num_vertices;
+    result.indices = data.num_indices;
+
+    if (gl) {
+        {
+            Model model;
+            size_t unlimited = std::numeric_limits<size_t>::max();
+            start = std::chrono::steady_clock::now();
+            model.uploadStep(data, unlimited);
+            glFinish();
+            result.upload_ms = millisecondsSince(start);
+        }
+        // the model released its textures, delete them so the next run uploads them again
+        TextureCache::global().purge();
+    }
+    return result;
+}
+
+static double median(std::vector<double> values) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+static constexpr uint32_t MODEL_UNIFORM = uniformHash("model");
+
+static DrawResult runDraw(const std::string &name, const std::string &path,
+                          const ModelLoadOptions &options, Shader &shader, size_t copies) {
+    DrawResult result;
+    result.model = name;
+    std::vector<glm::mat4> placements;
+    for (size_t i = 0; i < copies; ++i) {
+        placements.push_back(
+            glm::translate(glm::mat4(1.0f), glm::vec3(float(i % 32), 0.0f, float(i / 32))));
+    }
+
+    {
+        Model model(path, {}, false, options);
+        result.draws = copies * model.meshes.size();
+        // median CPU time of submitting a frame, the GPU work is waited for outside of it
+        auto time_frames = [&](auto submit) {
+            std::vector<double> times;
+            for (int frame = 0; frame < DRAW_FRAMES; ++frame) {
+                auto start = std::chrono::steady_clock::now();
+                submit();
+                times.push_back(millisecondsSince(start));
+                glFinish();
+            }
+            return median(times);
+        };
+
+        shader.use();
+        // the copies of a mesh are drawn in a row in both modes, as a sorted scene would
+        result.direct_ms = time_frames([&] {
+            Uniform model_uniform = shader.uniform(MODEL_UNIFORM);
+            for (const auto &mesh : model.meshes) {
+                for (const auto &placement : placements) {
+                    shader.setMat4(model_uniform, placement);
+                    mesh.Draw(shader);
+                }
+            }
+        });
+        if (hasIndirectDraw()) {
+            IndirectDrawList draws;
+            result.indirect_ms = time_frames([&] {
+                draws.clear();
+                for (const auto &mesh : model.meshes) {
+                    for (const auto &placement : placements) draws.add(mesh, 0, placement);
+                }
+                draws.submit(shader);
+            });
+            result.indirect_calls = draws.numCalls();
+        }
+    }
+    TextureCache::global().purge();
+    return result;
+}
+
+// total times of the runs per RunResult::key()
+static CullResult runCull(const std::string &name, const std::string &path,
+                          const ModelLoadOptions &options, size_t copies) {
+    CullResult result;
+    result.model = name;
+    ModelData data = Model::loadData(path, {}, options, true);
+
+    // about one copy per 4x4 square, the size of the models in the demo
+    float side = 4.0f * std::sqrt(float(copies));
+    std::mt19937 engine(1);
+    std::uniform_real_distribution<float> position(0.0f, side), angle(0.0f, 360.0f);
+    auto placement = [&]() {
+        glm::mat4 matrix =
+            glm::translate(glm::mat4(1.0f), glm::vec3(position(engine), 0.0f, position(engine)));
+        return glm::rotate(matrix, glm::radians(angle(engine)), glm::vec3(0.0f, 1.0f, 0.0f));
+    };
+    std::vector<Bounds> bounds;
+    for (size_t i = 0; i < copies; ++i) {
+        glm::mat4 matrix = placement();
+        for (const auto &mesh : data.meshes) bounds.push_back(mesh.bounds.transformed(matrix));
+    }
+    result.objects = bounds.size();
+
+    glm::vec3 camera_pos(side * 0.5f, 2.0f, -1.0f);
+    glm::mat4 view = glm::lookAt(camera_pos, camera_pos + glm::vec3(0.0f, 0.0f, 1.0f),
+                                 glm::vec3(0.0f, 1.0f, 0.0f));
+    float fov_y = glm::radians(45.0f);
+    Frustum frustum(glm::perspective(fov_y, 16.0f / 9.0f, 0.1f, 100.0f) * view);
+    float projection_scale = 1080.0f / (2.0f * std::tan(fov_y / 2.0f));
+    const float min_pixels = 1.0f;
+
+    Bvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(bounds);
+    result.build_ms = millisecondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < bounds.size() / 100; ++i) {
+        size_t object = engine() % bounds.size();
+        bvh.update(static_cast<uint32_t>(object), bounds[object].transformed(placement()));
+    }
+    result.refit_ms = millisecondsSince(start);
+
+    std::vector<double> bvh_times, flat_times;
+    std::vector<BoundsRange> leaves;
+    std::vector<uint32_t> visible;
+    BoundsList flat;
+    for (const auto &object : bounds) flat.add(object);
+    for (int frame = 0; frame < DRAW_FRAMES; ++frame) {
+        start = std::chrono::steady_clock::now();
+        leaves.clear();
+        visible.clear();
+        bvh.query(frustum, leaves);
+        cullBounds(frustum, bvh.leafBounds(), leaves, camera_pos, projection_scale, min_pixels,
+                   visible);
+        bvh_times.push_back(millisecondsSince(start));
+        result.visible = visible.size();
+
+        start = std::chrono::steady_clock::now();
+        visible.clear();
+        cullBounds(frustum, flat, camera_pos, projection_scale, min_pixels, visible);
+        flat_times.push_back(millisecondsSince(start));
+    }
+    result.bvh_ms = median(bvh_times);
+    result.flat_ms = median(flat_times);
+    return result;
+}
+
+static std::map<std::string, std::vector<double>> totalsByKey(
+    const std::vector<RunResult> &results) {
+    std::map<std::string, std::vector<double>> totals;
+    for (const auto &result : results) {
+        totals[result.key()].push_back(result.total());
+    }
+    return totals;
+}
+
+static const char *CSV_HEADER =
+    "model,preset,mode,run,meshes,vertices,indices,from_cache,read_ms,import_ms,convert_ms,"
+    "cache_write_ms,decode_ms,upload_ms,total_ms";
+static const size_t CSV_COLUMNS = 15;
+
+static void writeCsv(const std::string &path, const std::vector<RunResult> &results) {
+    std::ofstream out(path);
+    out << CSV_HEADER << '\n';
+    for (const auto &r : results) {
+        out << r.model << ',' << r.preset << ',' << r.mode << ',' << r.run << ',' << r.meshes
+            << ',' << r.vertices << ',' << r.indices << ',' << r.timings.from_cache << ','
+            << r.read_ms << ',' << r.timings.import_ms << ',' << r.timings.convert_ms << ','
+            << r.timings.cache_write_ms << ',' << r.timings.decode_ms << ',' << r.upload_ms << ','
+            << r.total() << '\n';
+    }
+}
+
+static void writeJson(const std::string &path, const std::vector<RunResult> &results) {
+    std::ofstream out(path);
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const RunResult &r = results[i];
+        out << "  {\"model\": \"" << r.model << "\", \"preset\": \"" << r.preset
+            << "\", \"mode\": \"" << r.mode << "\", \"run\": " << r.run
+            << ", \"meshes\": " << r.meshes << ", \"vertices\": " << r.vertices
+            << ", \"indices\": " << r.indices
+            << ", \"from_cache\": " << (r.timings.from_cache ? "true" : "false")
+            << ", \"read_ms\": " << r.read_ms << ", \"import_ms\": " << r.timings.import_ms
+            << ", \"convert_ms\": " << r.timings.convert_ms
+            << ", \"cache_write_ms\": " << r.timings.cache_write_ms
+            << ", \"decode_ms\": " << r.timings.decode_ms << ", \"upload_ms\": " << r.upload_ms
+            << ", \"total_ms\": " << r.total() << '}' << (i + 1 < results.size() ? "," : "")
+            << '\n';
+    }
+    out << "]\n";
+}
+
+// reads the total times of the runs in a CSV written by writeCsv into totals, per
+// RunResult::key(). Fails if the file can't be read, isn't such a CSV or has no runs, so a bad
+// baseline never passes the comparison.
+static bool readBaseline(const std::string &path,
+                         std::map<std::string, std::vector<double>> &totals) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "ERROR::BENCHMARK:: can't read baseline " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    std::getline(in, line);
+    if (line != CSV_HEADER) {
+        std::cout << "ERROR::BENCHMARK:: unexpected baseline format in " << path << std::endl;
+        return false;
+    }
+    size_t line_number = 1;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty()) continue;
+        std::vector<std::string> fields;
+        std::stringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ',')) fields.push_back(field);
+        char *end = nullptr;
+        double total = fields.size() == CSV_COLUMNS
+                           ? std::strtod(fields[CSV_COLUMNS - 1].c_str(), &end)
+                           : 0.0;
+        if (end == nullptr || *end != '\0' || end == fields[CSV_COLUMNS - 1].c_str()) {
+            std::cout << "ERROR::BENCHMARK:: malformed run in " << path << ':' << line_number
+                      << std::endl;
+            return false;
+        }
+        totals[fields[0] + '/' + fields[1] + '/' + fields[2]].push_back(total);
+    }
+    if (totals.empty()) {
+        std::cout << "ERROR::BENCHMARK:: no runs in baseline " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int runs = 3;
+    std::vector<std::string> models = DEFAULT_MODELS;
+    std::string csv_path, json_path, baseline_path;
+    double tolerance = 0.25;
+    bool gl = true;
+    size_t draw_copies = 0;
+    size_t cull_copies = 0;
+    std::vector<ImportPreset> presets = {ImportPreset::Exact};
+    ModelLoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--runs" && has_value) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--models" && has_value) {
+            models.clear();
+            std::stringstream list(argv[++i]);
+            std::string model;
+            while (std::getline(list, model, ',')) models.push_back(model);
+        } else if (arg == "--presets" && has_value) {
+            presets.clear();
+            std::stringstream list(argv[++i]);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                ImportPreset preset;
+                if (!parseImportPreset(name, preset)) {
+                    std::cout << "unknown import preset " << name << std::endl;
+                    return -1;
+                }
+                presets.push_back(preset);
+            }
+        } else if (arg == "--assimp") {
+            options.native_obj = false;
+        } else if (arg == "--csv" && has_value) {
+            csv_path = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            json_path = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            baseline_path = argv[++i];
+        } else if (arg == "--tolerance" && has_value) {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--no-gl") {
+            gl = false;
+        } else if (arg == "--draw" && has_value) {
+            draw_copies = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--cull" && has_value) {
+            cull_copies = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cout << "unknown option " << arg << ", see the top of " << __FILE__ << std::endl;
+            return -1;
+        }
+    }
+
+    // read before the runs, a baseline that can't be compared against fails right away
+    std::map<std::string, std::vector<double>> baseline;
+    if (!baseline_path.empty() && !readBaseline(baseline_path, baseline)) return 1;
+
+    // a hidden window is enough for a context, no frame is ever shown
+    GLFWwindow *window = nullptr;
+    if (gl && glfwInit()) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(1, 1, "model loading benchmark", NULL, NULL);
+    }
+    if (window) {
+        glfwMakeContextCurrent(window);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        std::cout << "GL renderer: " << glGetString(GL_RENDERER) << std::endl;
+        if (draw_copies > 0 && !loadIndirectDraw((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "no GL 4.3, drawing without multi draw indirect only" << std::endl;
+        }
+    } else if (gl) {
+        std::cout << "no GL context, skipping the upload phase" << std::endl;
+        gl = false;
+    }
+
+    std::vector<RunResult> results;
+    for (const auto &name : models) {
+        std::string path = findModelFile(name);
+        if (path.empty()) {
+            std::cout << "skipping " << name << ": no model file in " << OBJECTS_DIRECTORY << '/'
+                      << name << std::endl;
+            continue;
+        }
+        for (ImportPreset preset : presets) {
+            options.import_preset = preset;
+            for (bool cold : {true, false}) {
+                for (int run = 0; run < runs; ++run) {
+                    results.push_back(runOnce(name, path, options, cold, run, gl));
+                }
+            }
+        }
+    }
+
+    // the loaders log every mesh, so the summary comes last
+    std::cout << "\nmodel/preset/mode                vertices   indices    read  import convert   "
+                 "cache  decode  upload   total (median ms)\n";
+    std::map<std::string, std::vector<const RunResult *>> groups;
+    for (const auto &result : results) {
+        groups[result.key()].push_back(&result);
+    }
+    for (const auto &[key, group] : groups) {
+        auto phase = [&](auto get) {
+            std::vector<double> values;
+            for (const auto *result : group) values.push_back(get(*result));
+            return median(values);
+        };
+        // the counts don't change between runs
+        std::printf("%-30s %10zu %9zu %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f\n", key.c_str(),
+                    group.front()->vertices, group.front()->indices,
+                    phase([](const RunResult &r) { return r.read_ms; }),
+                    phase([](const RunResult &r) { return r.timings.import_ms; }),
+                    phase([](const RunResult &r) { return r.timings.convert_ms; }),
+                    phase([](const RunResult &r) { return r.timings.cache_write_ms; }),
+                    phase([](const RunResult &r) { return r.timings.decode_ms; }),
+                    phase([](const RunResult &r) { return r.upload_ms; }),
+                    phase([](const RunResult &r) { return r.total(); }));
+    }
+
+    if (draw_copies > 0 && gl) {
+        Shader shader("src/3.model_loading/1.model_loading/1.model_loading.vs",
+                      "src/3.model_loading/1.model_loading/1.model_loading.fs");
+        shader.use();
+        shader.setInt("skybox", 5);
+        Mesh::setSamplerUnits(shader);
+        shader.setInt("draw_data", IndirectDrawList::DRAW_DATA_TEXTURE_UNIT);
+        shader.setUniformBlockBinding("MaterialBlock", MATERIAL_BLOCK_BINDING);
+        Mesh::loadDummyTextures();
+        options.import_preset = presets.front();
+
+        std::vector<DrawResult> draw_results;
+        for (const auto &name : models) {
+            std::string path = findModelFile(name);
+            if (!path.empty()) {
+                draw_results.push_back(runDraw(name, path, options, shader, draw_copies));
+            }
+        }
+        std::cout << "\nmodel                draws  per mesh  indirect  indirect calls "
+                     "(median CPU ms per frame)\n";
+        for (const auto &r : draw_results) {
+            std::printf("%-18s %7zu %9.2f %9.2f %15zu\n", r.model.c_str(), r.draws, r.direct_ms,
+                        r.indirect_ms, r.indirect_calls);
+        }
+    }
+
+    if (cull_copies > 0) {
+        options.import_preset = presets.front();
+        std::vector<CullResult> cull_results;
+        for (const auto &name : models) {
+            std::string path = findModelFile(name);
+            if (!path.empty()) {
+                cull_results.push_back(runCull(name, path, options, cull_copies));
+            }
+        }
+        std::cout << "\nmodel              objects   visible     build  refit 1%       bvh "
+                     "     flat (ms, median per frame for the culls)\n";
+        for (const auto &r : cull_results) {
+            std::printf("%-18s %7zu %9zu %9.2f %9.2f %9.3f %9.3f\n", r.model.c_str(), r.objects,
+                        r.visible, r.build_ms, r.refit_ms, r.bvh_ms, r.flat_ms);
+        }
+    }
+
+    if (!csv_path.empty()) writeCsv(csv_path, results);
+    if (!json_path.empty()) writeJson(json_path, results);
+
+    int status = 0;
+    if (!baseline_path.empty()) {
+        // a run the baseline has no times for can't be checked, which fails like a regression
+        // until the baseline is recorded again
+        size_t missing = 0;
+        for (const auto &[key, totals] : totalsByKey(results)) {
+            auto base = baseline.find(key);
+            if (base == baseline.end()) {
+                std::printf("NO BASELINE %s\n", key.c_str());
+                ++missing;
+                status = 1;
+                continue;
+            }
+            double total = median(totals), base_total = median(base->second);
+            if (base_total > 0 && total > base_total * (1 + tolerance)) {
+                std::printf("REGRESSION %s: %.1f ms, baseline %.1f ms\n", key.c_str(), total,
+                            base_total);
+                status = 1;
+            }
+        }
+        if (missing > 0) {
+            std::printf("%zu model/preset/mode combinations have no baseline\n", missing);
+        }
+        if (results.empty()) {
+            std::cout << "ERROR::BENCHMARK:: no runs to compare with the baseline" << std::endl;
+            status = 1;
+        }
+    }
+
+    if (window) glfwTerminate();
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include <learnopengl/bounds.h>
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOUNDS_SSE2
+#endif
+
+// largest singular value of the upper 3x3 of matrix, the most it stretches any direction. The
+// column lengths aren't enough once a non uniform scale is combined with a rotation.
+static float maxScale(const glm::mat4 &matrix) {
+    glm::mat3 linear(matrix);
+    // eigenvalues of the symmetric m are the squared singular values, the largest one is found
+    // in closed form (Smith 1961)
+    glm::mat3 m = glm::transpose(linear) * linear;
+    float off_diagonal = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+    if (off_diagonal == 0.0f) return std::sqrt(std::max(std::max(m[0][0], m[1][1]), m[2][2]));
+    float q = (m[0][0] + m[1][1] + m[2][2]) / 3.0f;
+    float p = std::sqrt(((m[0][0] - q) * (m[0][0] - q) + (m[1][1] - q) * (m[1][1] - q) +
+                         (m[2][2] - q) * (m[2][2] - q) + 2.0f * off_diagonal) /
+                        6.0f);
+    glm::mat3 b = (m - glm::mat3(q)) / p;
+    float r = std::clamp(glm::determinant(b) * 0.5f, -1.0f, 1.0f);
+    return std::sqrt(q + 2.0f * p * std::cos(std::acos(r) / 3.0f));
+}
+
+void Bounds::merge(const Bounds &other) {
+    if (other.isEmpty()) return;
+    if (isEmpty()) {
+        *this = other;
+        return;
+    }
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+
+    // smallest sphere containing both spheres
+    glm::vec3 offset = other.center - center;
+    float distance = glm::length(offset);
+    if (distance + other.radius <= radius) return;
+    if (distance + radius <= other.radius) {
+        center = other.center;
+        radius = other.radius;
+        return;
+    }
+    float merged_radius = (distance + radius + other.radius) * 0.5f;
+    center += offset * ((merged_radius - radius) / distance);
+    radius = merged_radius;
+}
+
+Bounds Bounds::transformed(const glm::mat4 &matrix) const {
+    if (isEmpty()) return *this;
+    Bounds result;
+    glm::vec3 box_center = matrix * glm::vec4((min + max) * 0.5f, 1.0f);
+    glm::vec3 extent = (max - min) * 0.5f;
+    glm::vec3 new_extent(0.0f);
+    for (int column = 0; column < 3; ++column) {
+        new_extent += glm::abs(glm::vec3(matrix[column])) * extent[column];
+    }
+    result.min = box_center - new_extent;
+    result.max = box_center + new_extent;
+
+    result.center = matrix * glm::vec4(center, 1.0f);
+    result.radius = radius * maxScale(matrix);
+    return result;
+}
+
+Bounds computeBounds(const Vertex *vertices, size_t num_vertices) {
+    Bounds bounds;
+    if (num_vertices == 0) return bounds;
+
+#ifdef BOUNDS_SSE2
+    // Position is followed by Normal inside Vertex, so loading four floats from it stays within
+    // the vertex. The fourth lane holds Normal.x and is ignored.
+    static_assert(offsetof(Vertex, Position) + 4 * sizeof(float) <= sizeof(Vertex),
+                  "a 4-wide load from Vertex::Position must stay inside the vertex");
+    // two accumulators per reduction hide the latency of min/max
+    __m128 min0 = _mm_loadu_ps(&vertices[0].Position.x), max0 = min0;
+    __m128 min1 = min0, max1 = max0;
+    size_t i = 1;
+    for (; i + 1 < num_vertices; i += 2) {
+        __m128 p0 = _mm_loadu_ps(&vertices[i].Position.x);
+        __m128 p1 = _mm_loadu_ps(&vertices[i + 1].Position.x);
+        min0 = _mm_min_ps(min0, p0);
+        max0 = _mm_max_ps(max0, p0);
+        min1 = _mm_min_ps(min1, p1);
+        max1 = _mm_max_ps(max1, p1);
+    }
+    if (i < num_vertices) {
+        __m128 p = _mm_loadu_ps(&vertices[i].Position.x);
+        min0 = _mm_min_ps(min0, p);
+        max0 = _mm_max_ps(max0, p);
+    }
+    alignas(16) float lanes[2][4];
+    _mm_store_ps(lanes[0], _mm_min_ps(min0, min1));
+    _mm_store_ps(lanes[1], _mm_max_ps(max0, max1));
+    bounds.min = glm::vec3(lanes[0][0], lanes[0][1], lanes[0][2]);
+    bounds.max = glm::vec3(lanes[1][0], lanes[1][1], lanes[1][2]);
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+    // largest squared distance to the center, the fourth lane is masked out
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 center = _mm_set_ps(0.0f, bounds.center.z, bounds.center.y, bounds.center.x);
+    __m128 max_distance = _mm_setzero_ps();
+    for (i = 0; i < num_vertices; ++i) {
+        __m128 d = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(&vertices[i].Position.x), center), mask);
+        __m128 d2 = _mm_mul_ps(d, d);
+        // horizontal sum into every lane
+        d2 = _mm_add_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(2, 3, 0, 1)));
+        d2 = _mm_add_ps(d2, _mm_shuffle_ps(d2, d2, _MM_SHUFFLE(1, 0, 3, 2)));
+        max_distance = _mm_max_ps(max_distance, d2);
+    }
+    bounds.radius = std::sqrt(_mm_cvtss_f32(max_distance));
+#else
+    bounds.min = bounds.max = vertices[0].Position;
+    for (size_t i = 1; i < num_vertices; ++i) {
+        bounds.min = glm::min(bounds.min, vertices[i].Position);
+        bounds.max = glm::max(bounds.max, vertices[i].Position);
+    }
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    float max_distance = 0.0f;
+    for (size_t i = 0; i < num_vertices; ++i) {
+        glm::vec3 d = vertices[i].Position - bounds.center;
+        max_distance = std::max(max_distance, glm::dot(d, d));
+    }
+    bounds.radius = std::sqrt(max_distance);
+#endif
+    return bounds;
+}
\ No newline at end of file
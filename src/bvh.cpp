@@ -0,0 +1,264 @@
+#include <learnopengl/bvh.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <limits>
+
+// split candidates per axis of the binned SAH
+static constexpr int NUM_BINS = 16;
+
+// a box that grows around what is added to it, empty at first
+struct Box {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void grow(const glm::vec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void grow(const glm::vec3 &other_min, const glm::vec3 &other_max) {
+        min = glm::min(min, other_min);
+        max = glm::max(max, other_max);
+    }
+    float area() const {
+        if (min.x > max.x) return 0.0f;
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+};
+
+struct Bvh::BuildItem {
+    glm::vec3 min;
+    uint32_t object;
+    glm::vec3 max;
+    // box center, the position the splits are picked by
+    glm::vec3 centroid;
+};
+
+void Bvh::build(const std::vector<Bounds> &bounds) {
+    auto num_objects = static_cast<uint32_t>(bounds.size());
+    object_bounds = bounds;
+    std::vector<BuildItem> items(num_objects);
+    for (uint32_t i = 0; i < num_objects; ++i) {
+        items[i].min = bounds[i].min;
+        items[i].object = i;
+        items[i].max = bounds[i].max;
+        // empty bounds have a centroid of 0, whatever side they end up on they don't grow it
+        items[i].centroid =
+            bounds[i].isEmpty() ? glm::vec3(0.0f) : (bounds[i].min + bounds[i].max) * 0.5f;
+    }
+    position_leaves.resize(num_objects);
+
+    nodes.clear();
+    if (num_objects > 0) {
+        // a binary tree with at least one object per leaf has at most 2n - 1 nodes
+        nodes.resize(2 * static_cast<size_t>(num_objects) - 1);
+        std::atomic<uint32_t> num_nodes{1};
+        buildNode(items.data(), 0, 0, 0, num_objects, num_nodes);
+        nodes.resize(num_nodes);
+    }
+
+    leaf_objects.resize(num_objects);
+    object_positions.resize(num_objects);
+    leaf_bounds.clear();
+    for (uint32_t position = 0; position < num_objects; ++position) {
+        leaf_objects[position] = items[position].object;
+        object_positions[leaf_objects[position]] = position;
+        leaf_bounds.add(bounds[leaf_objects[position]]);
+    }
+}
+
+void Bvh::buildNode(BuildItem *items, uint32_t node, uint32_t depth, uint32_t first,
+                    uint32_t count, std::atomic<uint32_t> &num_nodes) {
+    Box box, centroid_box;
+    for (uint32_t i = first; i < first + count; ++i) {
+        box.grow(items[i].min, items[i].max);
+        centroid_box.grow(items[i].centroid);
+    }
+    nodes[node].min = box.min;
+    nodes[node].max = box.max;
+    nodes[node].first = first;
+    nodes[node].count = count;
+    nodes[node].child = 0;
+
+    // cullBounds tests the objects of a leaf in one or two SIMD groups, splitting it further
+    // saves nothing
+    if (count <= MAX_LEAF_SIZE) {
+        for (uint32_t i = first; i < first + count; ++i) position_leaves[i] = node;
+        return;
+    }
+
+    // the cost of a split is the number of objects on each side weighted by the chance that a
+    // query hitting the node also hits the side, which goes with the surface area of its box.
+    // All three axes are binned in one pass over the objects.
+    glm::vec3 centroid_size = centroid_box.max - centroid_box.min;
+    glm::vec3 bin_scale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (centroid_size[axis] > 0.0f) bin_scale[axis] = NUM_BINS / centroid_size[axis];
+    }
+    auto binOf = [&](const BuildItem &item, int axis) {
+        int bin = static_cast<int>((item.centroid[axis] - centroid_box.min[axis]) *
+                                   bin_scale[axis]);
+        return std::min(bin, NUM_BINS - 1);
+    };
+    Box bins[3][NUM_BINS];
+    uint32_t bin_counts[3][NUM_BINS] = {};
+    for (uint32_t i = first; i < first + count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            int bin = binOf(items[i], axis);
+            bins[axis][bin].grow(items[i].min, items[i].max);
+            ++bin_counts[axis][bin];
+        }
+    }
+
+    float best_cost = std::numeric_limits<float>::max();
+    int best_axis = -1;
+    int best_split = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (centroid_size[axis] <= 0.0f) continue;
+        // sweeps from the right for the areas right of every split, then from the left
+        float right_costs[NUM_BINS];
+        Box right;
+        uint32_t right_count = 0;
+        for (int split = NUM_BINS - 1; split > 0; --split) {
+            right.grow(bins[axis][split].min, bins[axis][split].max);
+            right_count += bin_counts[axis][split];
+            right_costs[split] = right.area() * right_count;
+        }
+        Box left;
+        uint32_t left_count = 0;
+        for (int split = 1; split < NUM_BINS; ++split) {
+            left.grow(bins[axis][split - 1].min, bins[axis][split - 1].max);
+            left_count += bin_counts[axis][split - 1];
+            if (left_count == 0 || left_count == count) continue;
+            float cost = left.area() * left_count + right_costs[split];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    BuildItem *begin = items + first;
+    BuildItem *middle;
+    if (depth >= MAX_DEPTH / 2) {
+        // deep enough that only degenerate inputs get here: halving the objects reaches the
+        // leaves before MAX_DEPTH whatever the SAH would pick
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (centroid_size[a] > centroid_size[axis]) axis = a;
+        }
+        middle = begin + count / 2;
+        std::nth_element(begin, middle, begin + count, [&](const BuildItem &a, const BuildItem &b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+    } else if (best_axis >= 0) {
+        middle = std::partition(begin, begin + count, [&](const BuildItem &item) {
+            return binOf(item, best_axis) < best_split;
+        });
+    } else {
+        // all centroids are the same point, any split is as good as another
+        middle = begin + count / 2;
+    }
+    auto left_count = static_cast<uint32_t>(middle - begin);
+
+    uint32_t child = num_nodes.fetch_add(2);
+    nodes[node].child = child;
+    nodes[child].parent = node;
+    nodes[child + 1].parent = node;
+    if (count > PARALLEL_BUILD_SIZE) {
+        // the children cover disjoint ranges of items and got their own nodes, so the subtrees
+        // are built without any locking
+        ThreadPool::global().parallelFor(2, [&](size_t side) {
+            if (side == 0) {
+                buildNode(items, child, depth + 1, first, left_count, num_nodes);
+            } else {
+                buildNode(items, child + 1, depth + 1, first + left_count, count - left_count,
+                          num_nodes);
+            }
+        });
+    } else {
+        buildNode(items, child, depth + 1, first, left_count, num_nodes);
+        buildNode(items, child + 1, depth + 1, first + left_count, count - left_count, num_nodes);
+    }
+}
+
+bool Bvh::refitNode(uint32_t node) {
+    Node &n = nodes[node];
+    Box box;
+    if (n.child == 0) {
+        for (uint32_t i = n.first; i < n.first + n.count; ++i) {
+            const Bounds &bounds = object_bounds[leaf_objects[i]];
+            box.grow(bounds.min, bounds.max);
+        }
+    } else {
+        box.grow(nodes[n.child].min, nodes[n.child].max);
+        box.grow(nodes[n.child + 1].min, nodes[n.child + 1].max);
+    }
+    if (box.min == n.min && box.max == n.max) return false;
+    n.min = box.min;
+    n.max = box.max;
+    return true;
+}
+
+void Bvh::update(uint32_t object, const Bounds &bounds) {
+    object_bounds[object] = bounds;
+    uint32_t position = object_positions[object];
+    leaf_bounds.set(position, bounds);
+    // the boxes of the ancestors only change as long as the ones below them did
+    uint32_t node = position_leaves[position];
+    while (refitNode(node) && node != 0) node = nodes[node].parent;
+}
+
+size_t Bvh::query(const Frustum &frustum, std::vector<BoundsRange> &ranges) const {
+    if (nodes.empty()) return 0;
+    glm::vec3 abs_normals[6];
+    for (int p = 0; p < 6; ++p) abs_normals[p] = glm::abs(glm::vec3(frustum.planes[p]));
+
+    // nodes still to visit, with the planes their parent wasn't entirely inside of
+    struct Entry {
+        uint32_t node;
+        uint32_t planes;
+    };
+    // at most one pending sibling per level plus the node being visited. A local, so any number
+    // of threads can query the same tree, and on the stack, so a query never allocates.
+    Entry stack[MAX_DEPTH + 1];
+    size_t stack_size = 0;
+    stack[stack_size++] = Entry{0, 0x3f};
+    size_t nodes_tested = 0;
+    while (stack_size > 0) {
+        Entry entry = stack[--stack_size];
+        const Node &node = nodes[entry.node];
+        ++nodes_tested;
+        // a subtree of empty bounds only
+        if (node.min.x > node.max.x) continue;
+
+        glm::vec3 center = (node.min + node.max) * 0.5f;
+        glm::vec3 extent = (node.max - node.min) * 0.5f;
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; ++p) {
+            if (!(entry.planes & (1u << p))) continue;
+            float distance = glm::dot(glm::vec3(frustum.planes[p]), center) + frustum.planes[p].w;
+            float reach = glm::dot(abs_normals[p], extent);
+            if (distance + reach < 0.0f) outside = true;
+            // the children are inside of a plane their parent is entirely inside of
+            if (distance - reach >= 0.0f) entry.planes &= ~(1u << p);
+        }
+        if (outside) continue;
+
+        if (node.child == 0 || entry.planes == 0) {
+            // leaves come out in increasing order, so neighbours merge into one range
+            if (!ranges.empty() && ranges.back().first + ranges.back().count == node.first) {
+                ranges.back().count += node.count;
+            } else {
+                ranges.push_back(BoundsRange{node.first, node.count});
+            }
+            continue;
+        }
+        // the left child is visited first, its objects come first in leaf order
+        stack[stack_size++] = Entry{node.child + 1, entry.planes};
+        stack[stack_size++] = Entry{node.child, entry.planes};
+    }
+    return nodes_tested;
+}
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include <learnopengl/cull.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define CULL_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CULL_SIMD
+#endif
+
+void BoundsList::clear() {
+    for (auto *component : {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z,
+                            &radius}) {
+        component->clear();
+    }
+}
+
+void BoundsList::add(const Bounds &bounds) {
+    for (auto *component : {&center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z,
+                            &radius}) {
+        component->push_back(0.0f);
+    }
+    set(size() - 1, bounds);
+}
+
+void BoundsList::set(size_t i, const Bounds &bounds) {
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+    // every comparison with NaN is false, so no plane test passes
+    if (bounds.isEmpty()) center = glm::vec3(std::numeric_limits<float>::quiet_NaN());
+    center_x[i] = center.x;
+    center_y[i] = center.y;
+    center_z[i] = center.z;
+    extent_x[i] = extent.x;
+    extent_y[i] = extent.y;
+    extent_z[i] = extent.z;
+    radius[i] = bounds.radius;
+}
+
+// the planes and the size threshold, as cullBounds uses them
+struct CullPlanes {
+    glm::vec4 planes[6];
+    // absolute values of the plane normals, the largest distance a corner of a box with a given
+    // extent has from its center along the normal
+    glm::vec3 abs_normals[6];
+    glm::vec3 camera_pos;
+    // (2 * projection_scale / min_pixels)^2, a sphere is large enough if
+    // radius^2 * size_scale >= distance^2
+    float size_scale;
+    bool size_test;
+};
+
+// the tests of cullBounds for object i, used for the objects left over by the SIMD loop
+static bool isVisible(const CullPlanes &cull, const BoundsList &bounds, size_t i, bool &outside) {
+    glm::vec3 center(bounds.center_x[i], bounds.center_y[i], bounds.center_z[i]);
+    glm::vec3 extent(bounds.extent_x[i], bounds.extent_y[i], bounds.extent_z[i]);
+    outside = false;
+    for (int p = 0; p < 6; ++p) {
+        float distance = glm::dot(glm::vec3(cull.planes[p]), center) + cull.planes[p].w;
+        if (!(distance + glm::dot(cull.abs_normals[p], extent) >= 0.0f)) {
+            outside = true;
+            return false;
+        }
+    }
+    if (!cull.size_test) return true;
+    glm::vec3 offset = center - cull.camera_pos;
+    return bounds.radius[i] * bounds.radius[i] * cull.size_scale >= glm::dot(offset, offset);
+}
+
+#ifdef CULL_SIMD
+// the few vector operations the kernel needs, on 8 floats with AVX and 4 with SSE
+#if defined(__AVX__)
+using Floats = __m256;
+static constexpr size_t LANES = 8;
+static Floats load(const float *values) { return _mm256_loadu_ps(values); }
+static Floats splat(float value) { return _mm256_set1_ps(value); }
+static Floats add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+static Floats sub(Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+static Floats mul(Floats a, Floats b) { return _mm256_mul_ps(a, b); }
+static Floats both(Floats a, Floats b) { return _mm256_and_ps(a, b); }
+// all bits set in the lanes where a >= b, false for NaN
+static Floats greaterEqual(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static Floats allSet() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+static unsigned laneMask(Floats mask) { return static_cast<unsigned>(_mm256_movemask_ps(mask)); }
+#else
+using Floats = __m128;
+static constexpr size_t LANES = 4;
+static Floats load(const float *values) { return _mm_loadu_ps(values); }
+static Floats splat(float value) { return _mm_set1_ps(value); }
+static Floats add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+static Floats sub(Floats a, Floats b) { return _mm_sub_ps(a, b); }
+static Floats mul(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+static Floats both(Floats a, Floats b) { return _mm_and_ps(a, b); }
+// all bits set in the lanes where a >= b, false for NaN
+static Floats greaterEqual(Floats a, Floats b) { return _mm_cmpge_ps(a, b); }
+static Floats allSet() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+static unsigned laneMask(Floats mask) { return static_cast<unsigned>(_mm_movemask_ps(mask)); }
+#endif
+
+static size_t countLanes(unsigned mask) {
+    size_t count = 0;
+    for (; mask != 0; mask &= mask - 1) ++count;
+    return count;
+}
+
+// appends first + lane for the lanes set in mask
+static void appendLanes(size_t first, unsigned mask, std::vector<uint32_t> &visible) {
+    for (; mask != 0; mask &= mask - 1) {
+        unsigned lane = 0;
+        while (!(mask & (1u << lane))) ++lane;
+        visible.push_back(static_cast<uint32_t>(first + lane));
+    }
+}
+
+// the planes and the camera of CullPlanes, every value repeated in all lanes
+struct SimdPlanes {
+    Floats normal_x[6], normal_y[6], normal_z[6], offset[6], abs_x[6], abs_y[6], abs_z[6];
+    Floats camera_x, camera_y, camera_z, size_scale;
+    bool size_test;
+
+    explicit SimdPlanes(const CullPlanes &cull) {
+        for (int p = 0; p < 6; ++p) {
+            normal_x[p] = splat(cull.planes[p].x);
+            normal_y[p] = splat(cull.planes[p].y);
+            normal_z[p] = splat(cull.planes[p].z);
+            offset[p] = splat(cull.planes[p].w);
+            abs_x[p] = splat(cull.abs_normals[p].x);
+            abs_y[p] = splat(cull.abs_normals[p].y);
+            abs_z[p] = splat(cull.abs_normals[p].z);
+        }
+        camera_x = splat(cull.camera_pos.x);
+        camera_y = splat(cull.camera_pos.y);
+        camera_z = splat(cull.camera_pos.z);
+        size_scale = splat(cull.size_scale);
+        size_test = cull.size_test;
+    }
+};
+
+// tests the objects of range in groups of LANES, returns the index of the first one left over.
+// The last group of a range may load objects past its end, those lanes are ignored, so only the
+// groups reaching past the end of bounds are left over.
+static size_t cullSimd(const SimdPlanes &simd, const BoundsList &bounds, BoundsRange range,
+                       CullStats &stats, std::vector<uint32_t> &visible) {
+    Floats zero = splat(0.0f);
+    size_t end = static_cast<size_t>(range.first) + range.count;
+    size_t i = range.first;
+    for (; i < end && i + LANES <= bounds.size(); i += LANES) {
+        size_t num_lanes = std::min(LANES, end - i);
+        unsigned lanes = (1u << num_lanes) - 1;
+        Floats center_x = load(&bounds.center_x[i]);
+        Floats center_y = load(&bounds.center_y[i]);
+        Floats center_z = load(&bounds.center_z[i]);
+        Floats extent_x = load(&bounds.extent_x[i]);
+        Floats extent_y = load(&bounds.extent_y[i]);
+        Floats extent_z = load(&bounds.extent_z[i]);
+
+        // a box is outside if it is entirely behind one of the planes: the distance of its
+        // center plus the extent along the normal is negative
+        Floats inside = allSet();
+        for (int p = 0; p < 6; ++p) {
+            Floats distance =
+                add(add(mul(simd.normal_x[p], center_x), mul(simd.normal_y[p], center_y)),
+                    add(mul(simd.normal_z[p], center_z), simd.offset[p]));
+            Floats reach = add(add(mul(simd.abs_x[p], extent_x), mul(simd.abs_y[p], extent_y)),
+                               mul(simd.abs_z[p], extent_z));
+            inside = both(inside, greaterEqual(add(distance, reach), zero));
+        }
+        unsigned inside_mask = laneMask(inside) & lanes;
+        stats.outside += num_lanes - countLanes(inside_mask);
+        if (inside_mask == 0) continue;
+        if (!simd.size_test) {
+            appendLanes(i, inside_mask, visible);
+            continue;
+        }
+
+        Floats dx = sub(center_x, simd.camera_x);
+        Floats dy = sub(center_y, simd.camera_y);
+        Floats dz = sub(center_z, simd.camera_z);
+        Floats distance_squared = add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+        Floats radius = load(&bounds.radius[i]);
+        Floats large = greaterEqual(mul(mul(radius, radius), simd.size_scale), distance_squared);
+        unsigned visible_mask = inside_mask & laneMask(large);
+        stats.too_small += countLanes(inside_mask & ~visible_mask);
+        appendLanes(i, visible_mask, visible);
+    }
+    return std::min(i, end);
+}
+#endif
+
+// both cullBounds overloads, for num_ranges ranges starting at ranges
+static CullStats cullRanges(const Frustum &frustum, const BoundsList &bounds,
+                            const BoundsRange *ranges, size_t num_ranges,
+                            const glm::vec3 &camera_pos, float projection_scale,
+                            float min_pixels, std::vector<uint32_t> &visible) {
+    CullPlanes cull;
+    for (int p = 0; p < 6; ++p) {
+        cull.planes[p] = frustum.planes[p];
+        cull.abs_normals[p] = glm::abs(glm::vec3(frustum.planes[p]));
+    }
+    cull.camera_pos = camera_pos;
+    // the sphere covers 2 * radius * projection_scale / distance pixels
+    cull.size_test = min_pixels > 0.0f;
+    float scale = cull.size_test ? 2.0f * projection_scale / min_pixels : 0.0f;
+    cull.size_scale = scale * scale;
+#ifdef CULL_SIMD
+    SimdPlanes simd(cull);
+#endif
+
+    CullStats stats;
+    for (size_t r = 0; r < num_ranges; ++r) {
+        const BoundsRange &range = ranges[r];
+        stats.tested += range.count;
+        size_t first = range.first;
+#ifdef CULL_SIMD
+        first = cullSimd(simd, bounds, range, stats, visible);
+#endif
+        for (size_t i = first; i < static_cast<size_t>(range.first) + range.count; ++i) {
+            bool outside;
+            if (isVisible(cull, bounds, i, outside)) {
+                visible.push_back(static_cast<uint32_t>(i));
+            } else if (outside) {
+                ++stats.outside;
+            } else {
+                ++stats.too_small;
+            }
+        }
+    }
+    return stats;
+}
+
+CullStats cullBounds(const Frustum &frustum, const BoundsList &bounds,
+                     const glm::vec3 &camera_pos, float projection_scale, float min_pixels,
+                     std::vector<uint32_t> &visible) {
+    // the whole list is one range, which needs no vector
+    BoundsRange all{0, static_cast<uint32_t>(bounds.size())};
+    return cullRanges(frustum, bounds, &all, bounds.size() > 0 ? 1 : 0, camera_pos,
+                      projection_scale, min_pixels, visible);
+}
+
+CullStats cullBounds(const Frustum &frustum, const BoundsList &bounds,
+                     const std::vector<BoundsRange> &ranges, const glm::vec3 &camera_pos,
+                     float projection_scale, float min_pixels, std::vector<uint32_t> &visible) {
+    return cullRanges(frustum, bounds, ranges.data(), ranges.size(), camera_pos,
+                      projection_scale, min_pixels, visible);
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include <learnopengl/geometry_buffer.h>
+#include <learnopengl/gl_state.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// replaces buffer by one of new_capacity bytes holding the first used bytes of the old one
+static void reallocateBuffer(unsigned int &buffer, size_t used, size_t new_capacity) {
+    GLState &state = GLState::global();
+    unsigned int new_buffer;
+    glGenBuffers(1, &new_buffer);
+    // the copy targets don't touch the element array binding of the bound VAO
+    state.bindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_capacity, nullptr, GL_STATIC_DRAW);
+    if (used > 0) {
+        state.bindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+    }
+    if (buffer != 0) state.deleteBuffers(1, &buffer);
+    buffer = new_buffer;
+}
+
+GeometryBuffer::Arena &GeometryBuffer::arena(const VertexLayout &layout) {
+    auto iter = arenas.find(layout.id);
+    if (iter != arenas.end()) return iter->second;
+
+    Arena &arena = arenas[layout.id];
+    arena.layout = layout;
+    glGenVertexArrays(1, &arena.vao);
+    return arena;
+}
+
+void GeometryBuffer::grow(Arena &arena, size_t vertex_bytes, size_t index_bytes) {
+    bool grown = false;
+    // doubling keeps the copies of a growing scene buffer linear in its final size
+    if (vertex_bytes > arena.vertex_capacity) {
+        size_t capacity = std::max(vertex_bytes, arena.vertex_capacity * 2);
+        reallocateBuffer(arena.vbo, arena.vertex_used, capacity);
+        arena.vertex_capacity = capacity;
+        grown = true;
+    }
+    if (index_bytes > arena.index_capacity) {
+        size_t capacity = std::max(index_bytes, arena.index_capacity * 2);
+        reallocateBuffer(arena.ebo, arena.index_used, capacity);
+        arena.index_capacity = capacity;
+        grown = true;
+    }
+    if (!grown) return;
+
+    // point the VAO at the new buffers, the offsets of the meshes stay valid
+    GLState &state = GLState::global();
+    state.bindVertexArray(arena.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, arena.vbo);
+    arena.layout.setAttributes();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.ebo);
+    // unbound, so code binding GL_ELEMENT_ARRAY_BUFFER without a VAO of its own can't change it
+    state.bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryBuffer::reserve(const VertexLayout &layout, size_t num_vertices,
+                             size_t index_bytes) {
+    Arena &arena = this->arena(layout);
+    grow(arena, arena.vertex_used + num_vertices * layout.stride,
+         alignUp(arena.index_used, INDEX_ALIGNMENT) + index_bytes);
+}
+
+GeometryBuffer::Range GeometryBuffer::allocate(const VertexLayout &layout,
+                                               const void *vertex_data, size_t num_vertices,
+                                               const void *index_data, size_t index_bytes) {
+    Arena &arena = this->arena(layout);
+    size_t base_vertex = arena.vertex_used / layout.stride;
+    if (base_vertex + num_vertices > size_t(std::numeric_limits<GLint>::max())) {
+        throw std::runtime_error("geometry buffer exceeds the base vertex range");
+    }
+    size_t vertex_offset = arena.vertex_used;
+    size_t index_offset = alignUp(arena.index_used, INDEX_ALIGNMENT);
+    size_t vertex_bytes = num_vertices * layout.stride;
+    grow(arena, vertex_offset + vertex_bytes, index_offset + index_bytes);
+
+    GLState &state = GLState::global();
+    if (vertex_bytes > 0) {
+        state.bindBuffer(GL_COPY_WRITE_BUFFER, arena.vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, vertex_bytes, vertex_data);
+    }
+    if (index_bytes > 0) {
+        state.bindBuffer(GL_COPY_WRITE_BUFFER, arena.ebo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, index_offset, index_bytes, index_data);
+    }
+    arena.vertex_used = vertex_offset + vertex_bytes;
+    arena.index_used = index_offset + index_bytes;
+
+    Range range;
+    range.vao = arena.vao;
+    range.base_vertex = static_cast<GLint>(base_vertex);
+    range.index_offset = index_offset;
+    return range;
+}
+
+void GeometryBuffer::release() {
+    GLState &state = GLState::global();
+    for (auto &[id, arena] : arenas) {
+        state.deleteVertexArrays(1, &arena.vao);
+        unsigned int buffers[] = {arena.vbo, arena.ebo};
+        state.deleteBuffers(2, buffers);
+    }
+    arenas.clear();
+}
+
+size_t GeometryBuffer::usedBytes() const {
+    size_t bytes = 0;
+    for (const auto &[id, arena] : arenas) {
+        bytes += arena.vertex_used + arena.index_used;
+    }
+    return bytes;
+}
+
+size_t GeometryBuffer::capacityBytes() const {
+    size_t bytes = 0;
+    for (const auto &[id, arena] : arenas) {
+        bytes += arena.vertex_capacity + arena.index_capacity;
+    }
+    return bytes;
+}
\ No newline at end of file
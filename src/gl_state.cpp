@@ -0,0 +1,198 @@
+#include <learnopengl/gl_state.h>
+
+#include <algorithm>
+
+// index of target in GLState::textures, or -1 for targets that aren't tracked
+static int textureTarget(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_2D:
+            return 0;
+        case GL_TEXTURE_CUBE_MAP:
+            return 1;
+        case GL_TEXTURE_2D_ARRAY:
+            return 2;
+        case GL_TEXTURE_BUFFER:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+// index of target in GLState::buffers, or -1 for targets that aren't tracked.
+// GL_ELEMENT_ARRAY_BUFFER belongs to the bound VAO, and GL_ARRAY_BUFFER is bound directly by the
+// vertex setup of every demo, so neither is tracked.
+static int bufferTarget(GLenum target) {
+    switch (target) {
+        case GL_UNIFORM_BUFFER:
+            return 0;
+        case GL_COPY_READ_BUFFER:
+            return 1;
+        case GL_COPY_WRITE_BUFFER:
+            return 2;
+        case GL_TEXTURE_BUFFER:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+GLState &GLState::global() {
+    static GLState state;
+    return state;
+}
+
+void GLState::invalidate() {
+    program = UNKNOWN;
+    vao = UNKNOWN;
+    active_unit = UNKNOWN;
+    for (auto &unit : textures) unit.fill(UNKNOWN);
+    buffers.fill(UNKNOWN);
+    uniform_ranges.fill(BufferRange());
+    depth.reset();
+    blend.reset();
+    cull.reset();
+    stencil.reset();
+}
+
+void GLState::useProgram(GLuint new_program) {
+    if (!changes(new_program != program)) return;
+    glUseProgram(new_program);
+    program = new_program;
+}
+
+void GLState::bindVertexArray(GLuint new_vao) {
+    if (!changes(new_vao != vao)) return;
+    glBindVertexArray(new_vao);
+    vao = new_vao;
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    int index = textureTarget(target);
+    if (unit < MAX_TEXTURE_UNITS && index >= 0 && textures[unit][index] == texture) {
+        changes(false);
+        return;
+    }
+    if (changes(unit != active_unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit = unit;
+    }
+    bindTexture(target, texture);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    int index = textureTarget(target);
+    if (active_unit >= MAX_TEXTURE_UNITS || index < 0) {
+        changes(true);
+        glBindTexture(target, texture);
+        return;
+    }
+    GLuint &bound = textures[active_unit][index];
+    if (!changes(texture != bound)) return;
+    glBindTexture(target, texture);
+    bound = texture;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer) {
+    int index = bufferTarget(target);
+    if (index < 0) {
+        changes(true);
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (!changes(buffer != buffers[index])) return;
+    glBindBuffer(target, buffer);
+    buffers[index] = buffer;
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                              GLsizeiptr size) {
+    BufferRange *range = nullptr;
+    if (target == GL_UNIFORM_BUFFER && index < MAX_UNIFORM_BINDINGS) {
+        range = &uniform_ranges[index];
+        if (range->buffer == buffer && range->offset == offset && range->size == size) {
+            changes(false);
+            return;
+        }
+    }
+    changes(true);
+    glBindBufferRange(target, index, buffer, offset, size);
+    if (range) *range = {buffer, offset, size};
+    // the generic binding point of target is set as well
+    int generic = bufferTarget(target);
+    if (generic >= 0) buffers[generic] = buffer;
+}
+
+void GLState::setDepth(const DepthState &state) {
+    bool known = depth.has_value();
+    if (changes(!known || depth->test != state.test)) setCapability(GL_DEPTH_TEST, state.test);
+    if (changes(!known || depth->write != state.write)) glDepthMask(state.write);
+    if (changes(!known || depth->func != state.func)) glDepthFunc(state.func);
+    depth = state;
+}
+
+void GLState::setBlend(const BlendState &state) {
+    bool known = blend.has_value();
+    if (changes(!known || blend->enabled != state.enabled)) setCapability(GL_BLEND, state.enabled);
+    if (changes(!known || blend->src != state.src || blend->dst != state.dst)) {
+        glBlendFunc(state.src, state.dst);
+    }
+    blend = state;
+}
+
+void GLState::setCull(const CullState &state) {
+    bool known = cull.has_value();
+    if (changes(!known || cull->enabled != state.enabled)) {
+        setCapability(GL_CULL_FACE, state.enabled);
+    }
+    if (changes(!known || cull->face != state.face)) glCullFace(state.face);
+    cull = state;
+}
+
+void GLState::setStencil(const StencilState &state) {
+    bool known = stencil.has_value();
+    if (changes(!known || stencil->test != state.test)) {
+        setCapability(GL_STENCIL_TEST, state.test);
+    }
+    if (changes(!known || stencil->func != state.func || stencil->ref != state.ref ||
+                stencil->read_mask != state.read_mask)) {
+        glStencilFunc(state.func, state.ref, state.read_mask);
+    }
+    if (changes(!known || stencil->write_mask != state.write_mask)) {
+        glStencilMask(state.write_mask);
+    }
+    if (changes(!known || stencil->stencil_fail != state.stencil_fail ||
+                stencil->depth_fail != state.depth_fail ||
+                stencil->depth_pass != state.depth_pass)) {
+        glStencilOp(state.stencil_fail, state.depth_fail, state.depth_pass);
+    }
+    stencil = state;
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint *ids) {
+    glDeleteTextures(count, ids);
+    // GL binds 0 wherever a deleted texture was bound, and the name may be handed out again
+    for (auto &unit : textures) {
+        for (auto &bound : unit) {
+            if (std::find(ids, ids + count, bound) != ids + count) bound = 0;
+        }
+    }
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint *ids) {
+    glDeleteBuffers(count, ids);
+    auto deleted = [&](GLuint buffer) {
+        return std::find(ids, ids + count, buffer) != ids + count;
+    };
+    for (auto &bound : buffers) {
+        if (deleted(bound)) bound = 0;
+    }
+    for (auto &range : uniform_ranges) {
+        if (deleted(range.buffer)) range = BufferRange{0, 0, 0};
+    }
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint *ids) {
+    glDeleteVertexArrays(count, ids);
+    if (std::find(ids, ids + count, vao) != ids + count) vao = 0;
+    ++vertex_array_deletions;
+}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include <learnopengl/gl_state.h>
+#include <learnopengl/indirect_draw.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+typedef void(APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type,
+                                                      const void *indirect, GLsizei drawcount,
+                                                      GLsizei stride);
+static MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+
+bool loadIndirectDraw(GLADloadproc load) {
+    // GLVersion is the version of the context, not the one glad was generated for
+    if (GLVersion.major < 4 || (GLVersion.major == 4 && GLVersion.minor < 3)) return false;
+    multiDrawElementsIndirect =
+        reinterpret_cast<MultiDrawElementsIndirectProc>(load("glMultiDrawElementsIndirect"));
+    return multiDrawElementsIndirect != nullptr;
+}
+
+bool hasIndirectDraw() { return multiDrawElementsIndirect != nullptr; }
+
+// 0, 1, 2, ... read through DRAW_INDEX_ATTRIBUTE with a divisor of 1, so the single instance of
+// a command with base_instance i reads i. All lists share it, so no VAO it is attached to ever
+// points at a buffer shorter than the list being drawn.
+static unsigned int draw_index_buffer = 0;
+static size_t draw_index_capacity = 0;
+static std::vector<unsigned int> draw_index_vaos;
+// GLState::vertexArrayDeletions() when draw_index_vaos was last known to hold no deleted VAO
+static size_t draw_index_vao_deletions = 0;
+
+static void reserveDrawIndices(size_t count) {
+    if (count <= draw_index_capacity) return;
+    draw_index_capacity = std::max(count, draw_index_capacity * 2);
+    std::vector<GLuint> indices(draw_index_capacity);
+    std::iota(indices.begin(), indices.end(), 0);
+    if (draw_index_buffer == 0) glGenBuffers(1, &draw_index_buffer);
+    // the VAOs refer to the buffer, not its storage, so they see the new contents
+    glBindBuffer(GL_ARRAY_BUFFER, draw_index_buffer);
+    glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// binds vao, attaching the draw indices to it the first time
+static void bindWithDrawIndices(unsigned int vao) {
+    GLState &state = GLState::global();
+    // a new VAO may get the name of a deleted one, so after a deletion the attribute is attached
+    // again; doing so to a VAO that has it already is harmless
+    if (state.vertexArrayDeletions() != draw_index_vao_deletions) {
+        draw_index_vaos.clear();
+        draw_index_vao_deletions = state.vertexArrayDeletions();
+    }
+    state.bindVertexArray(vao);
+    if (std::find(draw_index_vaos.begin(), draw_index_vaos.end(), vao) != draw_index_vaos.end()) {
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, draw_index_buffer);
+    glEnableVertexAttribArray(DRAW_INDEX_ATTRIBUTE);
+    glVertexAttribIPointer(DRAW_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *)0);
+    glVertexAttribDivisor(DRAW_INDEX_ATTRIBUTE, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    draw_index_vaos.push_back(vao);
+}
+
+size_t IndirectDrawList::maxChunkDraws() {
+    static const size_t max_draws = [] {
+        GLint max_texels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        // the minimum every GL 3.1 implementation supports
+        size_t texels = std::max<size_t>(static_cast<size_t>(max_texels), 65536);
+        return texels / (sizeof(DrawData) / sizeof(glm::vec4));
+    }();
+    return max_draws;
+}
+
+void IndirectDrawList::clear() {
+    commands.clear();
+    draws.clear();
+    buckets.clear();
+    chunk_first_draw = 0;
+}
+
+void IndirectDrawList::addBucket(const Mesh &mesh) {
+    if (draws.size() - chunk_first_draw == maxChunkDraws()) chunk_first_draw = draws.size();
+    if (!buckets.empty() && buckets.back().chunk_first_draw == chunk_first_draw) {
+        const Mesh &last = *buckets.back().mesh;
+        if (last.getVAO() == mesh.getVAO() && last.getIndexType() == mesh.getIndexType() &&
+            last.getTextureKey() == mesh.getTextureKey()) {
+            return;
+        }
+    }
+    buckets.push_back(Bucket{&mesh, commands.size(), 0, chunk_first_draw});
+}
+
+void IndirectDrawList::addDraw(const Mesh &mesh, const glm::mat4 &model) {
+    const MaterialBlock &block = mesh.getMaterialBlock();
+    DrawData draw;
+    draw.model = model;
+    draw.material[0] = glm::vec4(block.color_ambient, block.shininess);
+    draw.material[1] = glm::vec4(block.color_diffuse, block.dissolve);
+    draw.material[2] = glm::vec4(block.color_specular, block.use_diffuse_alpha);
+    draw.material[3] =
+        glm::vec4(block.diffuse_layer, block.specular_layer, block.reflection_layer, 0);
+    draws.push_back(draw);
+}
+
+void IndirectDrawList::addCommand(const Mesh &mesh, size_t first_index, size_t count) {
+    size_t index_size =
+        mesh.getIndexType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    DrawElementsIndirectCommand command;
+    command.count = static_cast<GLuint>(count);
+    command.instance_count = 1;
+    // the index offset of the mesh is aligned to GeometryBuffer::INDEX_ALIGNMENT, so it is a
+    // whole number of indices
+    command.first_index = static_cast<GLuint>(mesh.getIndexOffset() / index_size + first_index);
+    command.base_vertex = mesh.getBaseVertex();
+    command.base_instance = static_cast<GLuint>(draws.size() - 1 - chunk_first_draw);
+    commands.push_back(command);
+    ++buckets.back().num_commands;
+}
+
+void IndirectDrawList::add(const Mesh &mesh, size_t lod, const glm::mat4 &model) {
+    addBucket(mesh);
+    addDraw(mesh, model);
+    const MeshLod &mesh_lod = mesh.getLod(lod);
+    addCommand(mesh, mesh_lod.index_offset, mesh_lod.num_indices);
+}
+
+void IndirectDrawList::add(const Mesh &mesh, const std::vector<IndexRange> &ranges,
+                           const glm::mat4 &model) {
+    if (ranges.empty()) return;
+    addBucket(mesh);
+    addDraw(mesh, model);
+    for (const auto &range : ranges) addCommand(mesh, range.first, range.count);
+}
+
+static constexpr uint32_t USE_DRAW_DATA_UNIFORM = uniformHash("use_draw_data");
+
+void IndirectDrawList::submit(Shader &shader) {
+    if (commands.empty()) return;
+    GLState &state = GLState::global();
+    if (draw_texture == 0) {
+        glGenBuffers(1, &draw_buffer);
+        glGenBuffers(1, &command_buffer);
+        glGenTextures(1, &draw_texture);
+        // a generated name only becomes a buffer object when it is first bound, and core
+        // profiles refuse to attach anything else to a texture
+        state.bindBuffer(GL_TEXTURE_BUFFER, draw_buffer);
+        state.bindTexture(DRAW_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, draw_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, draw_buffer);
+    }
+
+    // both buffers are written anew every frame. glBufferData lets the driver hand out new
+    // storage instead of waiting for the draws of the last frame (or chunk) to finish reading
+    // the old one.
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand),
+                 commands.data(), GL_STREAM_DRAW);
+    reserveDrawIndices(std::min(draws.size(), maxChunkDraws()));
+
+    state.bindTexture(DRAW_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, draw_texture);
+    Uniform use_draw_data = shader.uniform(USE_DRAW_DATA_UNIFORM);
+    shader.setBool(use_draw_data, true);
+    size_t uploaded_chunk = std::numeric_limits<size_t>::max();
+    for (const auto &bucket : buckets) {
+        if (bucket.chunk_first_draw != uploaded_chunk) {
+            uploaded_chunk = bucket.chunk_first_draw;
+            size_t chunk_draws = std::min(draws.size() - uploaded_chunk, maxChunkDraws());
+            state.bindBuffer(GL_TEXTURE_BUFFER, draw_buffer);
+            glBufferData(GL_TEXTURE_BUFFER, chunk_draws * sizeof(DrawData),
+                         draws.data() + uploaded_chunk, GL_STREAM_DRAW);
+        }
+        bindWithDrawIndices(bucket.mesh->getVAO());
+        // the material constants come with the draws, so only the textures are bound
+        bucket.mesh->bindTextures();
+        multiDrawElementsIndirect(
+            GL_TRIANGLES, bucket.mesh->getIndexType(),
+            (const void *)(bucket.first_command * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(bucket.num_commands), 0);
+    }
+    shader.setBool(use_draw_data, false);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include <fcntl.h>
+#include <learnopengl/mapped_file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *ptr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            mapped = static_cast<const unsigned char *>(ptr);
+            mapped_size = static_cast<size_t>(st.st_size);
+        }
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : mapped(std::exchange(other.mapped, nullptr)),
+      mapped_size(std::exchange(other.mapped_size, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        mapped = std::exchange(other.mapped, nullptr);
+        mapped_size = std::exchange(other.mapped_size, 0);
+    }
+    return *this;
+}
+
+void MappedFile::close() {
+    if (mapped) {
+        munmap(const_cast<unsigned char *>(mapped), mapped_size);
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+}
\ No newline at end of file
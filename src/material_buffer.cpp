@@ -0,0 +1,83 @@
+#include <learnopengl/material_buffer.h>
+
+#include <algorithm>
+#include <cstring>
+
+MaterialBuffer &MaterialBuffer::global() {
+    static MaterialBuffer material_buffer;
+    return material_buffer;
+}
+
+size_t MaterialBuffer::add(const MaterialBlock &block) {
+    std::string block_key = key(block);
+    auto iter = offsets.find(block_key);
+    if (iter != offsets.end()) {
+        ++uses[iter->second / stride];
+        return iter->second;
+    }
+
+    if (stride == 0) {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+        stride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+        glGenBuffers(1, &buffer);
+    }
+
+    size_t offset;
+    if (!free_offsets.empty()) {
+        offset = free_offsets.back();
+        free_offsets.pop_back();
+        write(offset, block);
+    } else {
+        offset = contents.size();
+        contents.resize(offset + stride);
+        uses.push_back(0);
+        std::memcpy(&contents[offset], &block, sizeof(block));
+        GLState::global().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (contents.size() > capacity) {
+            // a few hundred materials at most, so the buffer is simply uploaded again as it grows
+            capacity = std::max(contents.size(), capacity * 2);
+            glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, contents.size(), contents.data());
+        } else {
+            glBufferSubData(GL_UNIFORM_BUFFER, offset, stride, &contents[offset]);
+        }
+        GLState::global().bindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    uses[offset / stride] = 1;
+    offsets.emplace(std::move(block_key), offset);
+    return offset;
+}
+
+size_t MaterialBuffer::update(size_t offset, const MaterialBlock &block) {
+    std::string block_key = key(block);
+    std::string old_key(reinterpret_cast<const char *>(&contents[offset]), sizeof(block));
+    if (block_key == old_key) return offset;
+
+    // the only user of the block and no identical block to share, so the slot is rewritten
+    if (uses[offset / stride] == 1 && offsets.find(block_key) == offsets.end()) {
+        offsets.erase(old_key);
+        write(offset, block);
+        offsets.emplace(std::move(block_key), offset);
+        return offset;
+    }
+    size_t new_offset = add(block);
+    release(offset);
+    return new_offset;
+}
+
+void MaterialBuffer::release(size_t offset) {
+    if (--uses[offset / stride] > 0) return;
+    offsets.erase(std::string(reinterpret_cast<const char *>(&contents[offset]),
+                              sizeof(MaterialBlock)));
+    free_offsets.push_back(offset);
+}
+
+void MaterialBuffer::write(size_t offset, const MaterialBlock &block) {
+    std::memcpy(&contents[offset], &block, sizeof(block));
+    GLState::global().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(block), &contents[offset]);
+    GLState::global().bindBuffer(GL_UNIFORM_BUFFER, 0);
+}
\ No newline at end of file
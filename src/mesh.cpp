@@ -1,127 +1,269 @@
 #include <assimp/scene.h>
+#include <learnopengl/gl_state.h>
 #include <learnopengl/mesh.h>
 
-std::map<aiTextureType, std::string> ai_texture_type_to_type = {
-    {aiTextureType_DIFFUSE, "texture_diffuse"},
-    {aiTextureType_SPECULAR, "texture_specular"},
-    {aiTextureType_AMBIENT, "texture_reflection"}};
-std::map<std::string, Texture> Mesh::dummy_textures;
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <limits>
+
+std::map<aiTextureType, TextureRole> ai_texture_type_to_role = {
+    {aiTextureType_DIFFUSE, TextureRole::Diffuse},
+    {aiTextureType_SPECULAR, TextureRole::Specular},
+    {aiTextureType_AMBIENT, TextureRole::Reflection}};
+std::array<Texture, NUM_TEXTURE_ROLES> Mesh::dummy_textures;
+
+// VertexFormat::Packed vertex. The skin part is only stored for meshes with bones.
+struct PackedVertex {
+    glm::vec3 Position;
+    // snorm 10-10-10-2, read as GL_INT_2_10_10_10_REV
+    uint32_t Normal;
+    uint32_t Tangent;
+    // two half floats
+    uint32_t TexCoords;
+};
+
+struct PackedSkin {
+    int16_t m_BoneIDs[MAX_BONE_INFLUENCE];
+    // unorm8
+    uint8_t m_Weights[MAX_BONE_INFLUENCE];
+};
+
+static_assert(sizeof(PackedVertex) == 24 && sizeof(PackedSkin) == 12, "unexpected padding");
+
+// ids of the vertex layouts in a GeometryBuffer
+enum VertexLayoutId : unsigned int { LAYOUT_FULL, LAYOUT_PACKED, LAYOUT_PACKED_SKINNED };
+
+// indices of small meshes fit in 16 bits, which halves the index buffer
+static bool useShortIndices(size_t num_vertices) {
+    return num_vertices <= std::numeric_limits<uint16_t>::max() + size_t(1);
+}
+
+// packs the vertices in the layout of the packed format, with a PackedSkin after every vertex if
+// has_bones is set
+static void packVertices(const Vertex *vertices, size_t num_vertices, bool has_bones,
+                         std::vector<unsigned char> &packed) {
+    size_t stride = sizeof(PackedVertex) + (has_bones ? sizeof(PackedSkin) : 0);
+    packed.resize(num_vertices * stride);
+    for (size_t i = 0; i < num_vertices; ++i) {
+        const Vertex &vertex = vertices[i];
+        PackedVertex out;
+        out.Position = vertex.Position;
+        out.Normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f));
+        // the bitangent only survives as the handedness of the tangent frame
+        float sign =
+            glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f
+                                                                                         : 1.0f;
+        out.Tangent = glm::packSnorm3x10_1x2(glm::vec4(vertex.Tangent, sign));
+        out.TexCoords = glm::packHalf2x16(vertex.TexCoords);
+        std::memcpy(&packed[i * stride], &out, sizeof(out));
+
+        if (has_bones) {
+            PackedSkin skin;
+            for (int j = 0; j < MAX_BONE_INFLUENCE; ++j) {
+                skin.m_BoneIDs[j] = static_cast<int16_t>(vertex.m_BoneIDs[j]);
+                skin.m_Weights[j] = static_cast<uint8_t>(
+                    glm::clamp(vertex.m_Weights[j], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            std::memcpy(&packed[i * stride + sizeof(out)], &skin, sizeof(skin));
+        }
+    }
+}
 
 Mesh::Mesh(const std::string &name, std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-           std::multimap<std::string, Texture> textures, Material material) {
-    this->name = name;
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
-    this->material = material;
+           std::vector<Texture> textures, Material material, VertexFormat format,
+           bool has_bones, CpuResidency residency, GeometryBuffer *geometry_buffer)
+    : name(name),
+      vertices(std::move(vertices)),
+      indices(std::move(indices)),
+      textures(std::move(textures)),
+      material(std::move(material)) {
+    this->num_indices = this->indices.size();
+    this->lods = {MeshLod{0, this->num_indices, 0.0f}};
+    this->format = format;
+    this->has_bones = has_bones;
 
     // now that we have all the required data, set the vertex buffers and its attribute
     // pointers.
-    setupMesh();
-}
-
-void Mesh::Draw(Shader &shader) const {
-    // bind appropriate textures
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
-    unsigned int normalNr = 1;
-    unsigned int heightNr = 1;
-    unsigned int reflectionNr = 1;
-    size_t i = 0;
-
-    auto bind_texture = [&](const std::string &type, unsigned id) {
-        glActiveTexture(GL_TEXTURE0 + i);  // active proper texture unit before binding
-        // retrieve texture number (the N in diffuse_textureN)
-        std::string number;
-        std::string name = type;
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNr++);  // transfer unsigned int to string
-        else if (name == "texture_normal")
-            number = std::to_string(normalNr++);  // transfer unsigned int to string
-        else if (name == "texture_height")
-            number = std::to_string(heightNr++);  // transfer unsigned int to string
-        else if (name == "texture_reflection")
-            number = std::to_string(reflectionNr++);  // transfer unsigned int to string
-
-        // now set the sampler to the correct texture unit
-        shader.setInt(("material." + name + number).c_str(), i);
-        // and finally bind the texture
-        glBindTexture(GL_TEXTURE_2D, id);
-
-        ++i;
-    };
+    setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), geometry_buffer);
+    if (residency == CpuResidency::Release) {
+        releaseCpuData();
+    }
+}
+
+Mesh::Mesh(const std::string &name, const Vertex *vertex_data, size_t num_vertices,
+           const unsigned int *index_data, size_t num_indices,
+           std::vector<Texture> textures, Material material, VertexFormat format,
+           bool has_bones, std::vector<MeshLod> lods, CpuResidency residency,
+           const Bounds *bounds, GeometryBuffer *geometry_buffer)
+    : name(name), textures(std::move(textures)), material(std::move(material)) {
+    this->num_indices = num_indices;
+    this->lods = std::move(lods);
+    if (this->lods.empty()) this->lods.push_back(MeshLod{0, num_indices, 0.0f});
+    this->format = format;
+    this->has_bones = has_bones;
+    if (bounds) this->bounds = *bounds;
+
+    setupMesh(vertex_data, num_vertices, index_data, geometry_buffer);
+    if (residency == CpuResidency::Keep) {
+        vertices.assign(vertex_data, vertex_data + num_vertices);
+        indices.assign(index_data, index_data + num_indices);
+    }
+}
+
+void Mesh::releaseCpuData() {
+    std::vector<Vertex>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
+
+size_t Mesh::residentBytes() const {
+    return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) +
+           lods.capacity() * sizeof(MeshLod) + meshlets.capacity() * sizeof(Meshlet);
+}
+
+void Mesh::Draw(Shader &shader, size_t lod) const {
+    // stays bound, so the next mesh in the same GeometryBuffer doesn't bind it again
+    GLState::global().bindVertexArray(geometry.vao);
+    DrawWithBoundVAO(lod);
+}
+
+void Mesh::DrawWithBoundVAO(size_t lod) const {
+    bindMaterial();
 
-    for (const auto &dummy_texture : Mesh::dummy_textures) {
-        auto range = textures.equal_range(dummy_texture.first);
-        for (auto iter = range.first; iter != range.second; ++iter) {
-            bind_texture(iter->second.type, iter->second.id);
+    // draw mesh
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(lods[lod].num_indices),
+                             index_type, indexPointer(lods[lod].index_offset),
+                             geometry.base_vertex);
+}
+
+size_t Mesh::visibleMeshlets(const Frustum &frustum, const glm::vec3 &camera_pos,
+                             bool cull_backfacing, std::vector<IndexRange> &ranges) const {
+    // visible meshlets that follow each other in the index buffer are merged into one range
+    size_t visible = 0;
+    size_t first_range = ranges.size();
+    uint32_t range_end = UINT32_MAX;
+    for (const auto &meshlet : meshlets) {
+        if ((cull_backfacing && meshlet.isBackfacing(camera_pos)) ||
+            !frustum.intersectsSphere(meshlet.center, meshlet.radius)) {
+            continue;
         }
-        if (range.first == range.second) {
-            bind_texture(dummy_texture.second.type, dummy_texture.second.id);
+        ++visible;
+        if (ranges.size() > first_range && meshlet.index_offset == range_end) {
+            ranges.back().count += meshlet.num_indices;
+        } else {
+            ranges.push_back(IndexRange{meshlet.index_offset, meshlet.num_indices});
         }
+        range_end = meshlet.index_offset + meshlet.num_indices;
     }
+    return visible;
+}
 
-    if (material.color_ambient == glm::vec3(0.0) && material.color_diffuse == glm::vec3(0.0)) {
-        shader.setVec3("material.color_ambient", glm::vec3(1.0));
-        shader.setVec3("material.color_diffuse", glm::vec3(1.0));
-    } else {
-        shader.setVec3("material.color_ambient", material.color_ambient);
-        shader.setVec3("material.color_diffuse", material.color_diffuse);
+size_t Mesh::DrawMeshlets(const Frustum &frustum, const glm::vec3 &camera_pos,
+                          bool cull_backfacing) const {
+    GLState::global().bindVertexArray(geometry.vao);
+    if (meshlets.empty()) {
+        DrawWithBoundVAO();
+        return 0;
     }
-    shader.setVec3("material.color_specular", material.color_specular);
-    shader.setFloat("material.shininess", material.shininess);
-    shader.setFloat("material.dissolve", material.dissolve);
 
-    auto iter = textures.find("texture_diffuse");
-    if (iter != textures.end()) {
-        shader.setBool("material.use_diffuse_alpha", iter->second.num_components == 4);
-    } else {
-        shader.setBool("material.use_dissuse_alpha", false);
+    meshlet_ranges.clear();
+    size_t visible = visibleMeshlets(frustum, camera_pos, cull_backfacing, meshlet_ranges);
+    if (meshlet_ranges.empty()) return 0;
+
+    meshlet_counts.clear();
+    meshlet_offsets.clear();
+    for (const auto &range : meshlet_ranges) {
+        meshlet_counts.push_back(static_cast<GLsizei>(range.count));
+        meshlet_offsets.push_back(indexPointer(range.first));
     }
+    // all ranges are relative to the first vertex of the mesh
+    meshlet_base_vertices.assign(meshlet_counts.size(), geometry.base_vertex);
 
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    bindMaterial();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, meshlet_counts.data(), index_type,
+                                  meshlet_offsets.data(),
+                                  static_cast<GLsizei>(meshlet_counts.size()),
+                                  meshlet_base_vertices.data());
+    return visible;
+}
 
-    // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
+// meshes binding the same textures get the same key. Keys are numbered in the order they are
+// first seen, so the few bits a RenderQueue key has for them tell them apart. Only called on the
+// GL thread.
+static uint32_t textureKey(std::vector<unsigned int> ids) {
+    static std::map<std::vector<unsigned int>, uint32_t> keys;
+    auto next_key = static_cast<uint32_t>(keys.size());
+    return keys.try_emplace(std::move(ids), next_key).first->second;
 }
 
-void Mesh::loadDummyTextures() {
-    std::unordered_map<aiTextureType, std::string> dummy_textures{
-        {aiTextureType_DIFFUSE, "dummy_white.png"},
-        {aiTextureType_SPECULAR, "dummy_white.png"},
-        {aiTextureType_AMBIENT, "dummy_black.png"}};
-    for (auto &[ai_type, name] : dummy_textures) {
-        Texture texture = TextureFromFile(name, "resources/textures");
-        texture.type = ai_texture_type_to_type[ai_type];
-        Mesh::dummy_textures[texture.type] = texture;
+int Mesh::textureUnit(TextureRole role) {
+    switch (role) {
+        case TextureRole::Diffuse:
+            return 0;
+        case TextureRole::Specular:
+            return 1;
+        case TextureRole::Reflection:
+            return 2;
+        default:
+            return -1;
     }
 }
 
-void Mesh::setupMesh() {
-    // create buffers/arrays
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+void Mesh::setSamplerUnits(Shader &shader) {
+    for (size_t i = 0; i < NUM_TEXTURE_ROLES; ++i) {
+        auto role = static_cast<TextureRole>(i);
+        int unit = textureUnit(role);
+        if (unit < 0) continue;
+        // the model loading shader has its samplers in a material struct, the simpler ones don't
+        std::string name = textureRoleName(role);
+        shader.setInt(name + "1", unit);
+        shader.setInt("material." + name + "1", unit);
+        // always set, a sampler2D and a sampler2DArray on the same unit fail the draw
+        shader.setInt("material." + name + "_array", static_cast<int>(TEXTURE_ARRAY_UNIT) + unit);
+    }
+}
 
-    glBindVertexArray(VAO);
-    // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    // A great thing about structs is that their memory layout is sequential for all its items.
-    // The effect is that we can simply pass a pointer to the struct and it translates perfectly
-    // to a glm::vec3/2 array which again translates to 3/2 floats which translates to a byte
-    // array.
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+void Mesh::bindMaterial() const {
+    bindTextures();
+    MaterialBuffer::global().bind(material_offset);
+}
+
+void Mesh::bindTextures() const {
+    // resolved by setupMaterial, the dummy textures are the same for most meshes, so most of the
+    // binds are elided
+    GLState &state = GLState::global();
+    for (size_t i = 0; i < num_texture_bindings; ++i) {
+        const TextureBinding &binding = texture_bindings[i];
+        state.bindTexture(binding.unit, binding.target, binding.id);
+    }
+}
+
+void Mesh::setTextureLayers(const std::unordered_map<unsigned int, TextureLayer> &layers) {
+    for (auto &texture : textures) {
+        auto layer = layers.find(texture.id);
+        if (layer == layers.end()) continue;
+        texture.array_id = layer->second.array;
+        texture.layer = layer->second.layer;
+    }
+    setupMaterial();
+    // only the layers changed, the old block is rewritten rather than orphaned
+    material_offset = MaterialBuffer::global().update(material_offset, material_block);
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0],
-                 GL_STATIC_DRAW);
+void Mesh::loadDummyTextures() {
+    std::pair<TextureRole, const char *> files[] = {{TextureRole::Diffuse, "dummy_white.png"},
+                                                    {TextureRole::Specular, "dummy_white.png"},
+                                                    {TextureRole::Reflection, "dummy_black.png"}};
+    for (auto &[role, name] : files) {
+        Texture texture = TextureFromFile(name, "resources/textures");
+        texture.role = role;
+        dummy_textures[static_cast<size_t>(role)] = texture;
+    }
+}
 
-    // set the vertex attribute pointers
+// attribute pointers of VertexFormat::Full
+static void setFullAttributes() {
     // vertex Positions
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
@@ -149,5 +291,168 @@ void Mesh::setupMesh() {
     glEnableVertexAttribArray(6);
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void *)offsetof(Vertex, m_Weights));
-    glBindVertexArray(0);
+}
+
+// attribute pointers of the PackedVertex part of VertexFormat::Packed
+static void setPackedVertexAttributes(GLsizei stride) {
+    // vertex Positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    // vertex normals, unpacked to [-1, 1] by GL
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                          (void *)offsetof(PackedVertex, Normal));
+    // vertex texture coords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                          (void *)offsetof(PackedVertex, TexCoords));
+    // vertex tangent, w is the bitangent sign
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                          (void *)offsetof(PackedVertex, Tangent));
+}
+
+static void setPackedAttributes() { setPackedVertexAttributes(sizeof(PackedVertex)); }
+
+static void setPackedSkinnedAttributes() {
+    GLsizei stride = sizeof(PackedVertex) + sizeof(PackedSkin);
+    setPackedVertexAttributes(stride);
+    // ids
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 4, GL_SHORT, stride,
+                           (void *)(sizeof(PackedVertex) + offsetof(PackedSkin, m_BoneIDs)));
+    // weights
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                          (void *)(sizeof(PackedVertex) + offsetof(PackedSkin, m_Weights)));
+}
+
+VertexLayout Mesh::vertexLayout(VertexFormat format, bool has_bones) {
+    if (format == VertexFormat::Full) {
+        return VertexLayout{LAYOUT_FULL, sizeof(Vertex), setFullAttributes};
+    }
+    if (has_bones) {
+        return VertexLayout{LAYOUT_PACKED_SKINNED, sizeof(PackedVertex) + sizeof(PackedSkin),
+                            setPackedSkinnedAttributes};
+    }
+    return VertexLayout{LAYOUT_PACKED, sizeof(PackedVertex), setPackedAttributes};
+}
+
+void Mesh::reserveGeometry(GeometryBuffer &geometry, const std::vector<MeshView> &meshes,
+                           VertexFormat format) {
+    struct Totals {
+        VertexLayout layout;
+        size_t num_vertices = 0;
+        size_t index_bytes = 0;
+    };
+    std::map<unsigned int, Totals> totals;
+    for (const auto &mesh : meshes) {
+        VertexLayout layout = vertexLayout(format, mesh.has_bones);
+        Totals &layout_totals = totals[layout.id];
+        layout_totals.layout = layout;
+        layout_totals.num_vertices += mesh.num_vertices;
+        size_t index_size =
+            useShortIndices(mesh.num_vertices) ? sizeof(uint16_t) : sizeof(unsigned int);
+        // every allocation may be padded up to the index alignment
+        layout_totals.index_bytes += mesh.num_indices * index_size +
+                                     GeometryBuffer::INDEX_ALIGNMENT - 1;
+    }
+    for (const auto &[id, layout_totals] : totals) {
+        geometry.reserve(layout_totals.layout, layout_totals.num_vertices,
+                         layout_totals.index_bytes);
+    }
+}
+
+void Mesh::setupMesh(const Vertex *vertex_data, size_t num_vertices,
+                     const unsigned int *index_data, GeometryBuffer *geometry_buffer) {
+    // unless the importer computed them already
+    if (bounds.isEmpty()) bounds = computeBounds(vertex_data, num_vertices);
+
+    if (geometry_buffer == nullptr) {
+        own_geometry = std::make_shared<GeometryBuffer>();
+        geometry_buffer = own_geometry.get();
+    }
+
+    // the converted vertices and indices only live until they are uploaded
+    std::vector<unsigned char> packed;
+    std::vector<uint16_t> short_indices;
+    // A great thing about structs is that their memory layout is sequential for all its items.
+    // The effect is that we can simply pass a pointer to the struct and it translates perfectly
+    // to a glm::vec3/2 array which again translates to 3/2 floats which translates to a byte
+    // array.
+    const void *vertices = vertex_data;
+    if (format == VertexFormat::Packed) {
+        packVertices(vertex_data, num_vertices, has_bones, packed);
+        vertices = packed.data();
+    }
+
+    const void *indices = index_data;
+    size_t index_bytes = num_indices * sizeof(unsigned int);
+    if (useShortIndices(num_vertices)) {
+        short_indices.assign(index_data, index_data + num_indices);
+        indices = short_indices.data();
+        index_bytes = num_indices * sizeof(uint16_t);
+        index_type = GL_UNSIGNED_SHORT;
+    } else {
+        index_type = GL_UNSIGNED_INT;
+    }
+
+    geometry = geometry_buffer->allocate(vertexLayout(format, has_bones), vertices, num_vertices,
+                                         indices, index_bytes);
+    setupMaterial();
+    material_offset = MaterialBuffer::global().add(material_block);
+}
+
+void Mesh::setupMaterial() {
+    // the callers write material_block to the uniform buffer
+    MaterialBlock block;
+    if (material.color_ambient == glm::vec3(0.0) && material.color_diffuse == glm::vec3(0.0)) {
+        block.color_ambient = glm::vec3(1.0);
+        block.color_diffuse = glm::vec3(1.0);
+    } else {
+        block.color_ambient = material.color_ambient;
+        block.color_diffuse = material.color_diffuse;
+    }
+    block.color_specular = material.color_specular;
+    block.shininess = material.shininess;
+    block.dissolve = material.dissolve;
+    auto first_texture = [&](TextureRole role) {
+        return std::find_if(textures.begin(), textures.end(),
+                            [&](const Texture &texture) { return texture.role == role; });
+    };
+    auto diffuse = first_texture(TextureRole::Diffuse);
+    block.use_diffuse_alpha = diffuse != textures.end() && diffuse->num_components == 4;
+
+    // the first texture of every role with a unit is bound, or the dummy texture of the role if
+    // the mesh has none. Packed textures are bound as their array, so the texture key of the
+    // meshes in layers of the same arrays is the same.
+    int32_t *layers[MAX_TEXTURE_BINDINGS] = {&block.diffuse_layer, &block.specular_layer,
+                                             &block.reflection_layer};
+    std::vector<unsigned int> ids;
+    num_texture_bindings = 0;
+    for (size_t i = 0; i < NUM_TEXTURE_ROLES; ++i) {
+        auto role = static_cast<TextureRole>(i);
+        int unit = textureUnit(role);
+        if (unit < 0) continue;
+        auto texture = first_texture(role);
+        TextureBinding binding;
+        binding.unit = static_cast<GLuint>(unit);
+        if (texture == textures.end()) {
+            binding.id = dummy_textures[i].id;
+        } else if (texture->array_id != 0) {
+            binding.unit += TEXTURE_ARRAY_UNIT;
+            binding.target = GL_TEXTURE_2D_ARRAY;
+            binding.id = texture->array_id;
+            *layers[unit] = texture->layer;
+        } else {
+            binding.id = texture->id;
+        }
+        // no dummy textures loaded
+        if (binding.id == 0) continue;
+        texture_bindings[num_texture_bindings++] = binding;
+        ids.push_back(binding.unit);
+        ids.push_back(binding.id);
+    }
+    material_block = block;
+    texture_key = textureKey(std::move(ids));
 }
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include <learnopengl/mesh_cache.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+// bump whenever the layout of the file or of the cached data changes
+static const uint32_t CACHE_VERSION = 8;
+static const char CACHE_MAGIC[8] = {'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H'};
+// vertex and index arrays are aligned in the file so they can be used in place once mapped
+static const size_t CACHE_ALIGNMENT = 16;
+static const uint32_t CACHE_PARTIAL = 1;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertex_size;
+    uint32_t import_flags;
+    uint32_t processing_flags;
+    uint32_t num_meshes;
+    // CACHE_PARTIAL if only some meshes of the source file are cached
+    uint32_t flags;
+    // CacheSourceRecords following the header
+    uint32_t num_sources;
+    uint32_t padding;
+    uint64_t toc_offset;
+};
+
+// a file the meshes were imported from, followed by its path relative to the directory of the
+// model file as a length prefixed string. The first one is the model file itself, with an empty
+// path, the others are the material libraries an OBJ file names.
+struct CacheSourceRecord {
+    // SOURCE_MISSING if the file didn't exist when the cache was written
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+};
+
+static const uint64_t SOURCE_MISSING = ~0ull;
+
+// fixed part of a mesh record, followed by the mesh name, the material name and the texture
+// references as length prefixed strings, num_lods CacheLodRecords and num_meshlets Meshlets
+struct CacheMeshRecord {
+    uint64_t vertices_offset;
+    uint64_t num_vertices;
+    uint64_t indices_offset;
+    uint64_t num_indices;
+    float color_ambient[3];
+    float color_diffuse[3];
+    float color_specular[3];
+    float shininess;
+    float dissolve;
+    float refracti;
+    float bounds_min[3];
+    float bounds_max[3];
+    float bounds_center[3];
+    float bounds_radius;
+    uint32_t num_textures;
+    uint32_t has_bones;
+    uint32_t num_lods;
+    uint32_t num_meshlets;
+};
+
+struct CacheLodRecord {
+    uint64_t index_offset;
+    uint64_t num_indices;
+    float error;
+    uint32_t padding;
+};
+
+struct SourceInfo {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+};
+
+static bool getSourceInfo(const std::string &path, SourceInfo &info) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    info.size = size;
+    info.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+// FNV-1a over the whole source file
+static uint64_t hashSource(const std::string &path) {
+    MappedFile source(path);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < source.size(); ++i) {
+        hash ^= source.data()[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// the material libraries an OBJ file names, as written in its mtllib statements
+static std::vector<std::string> materialLibraries(const std::string &path) {
+    std::vector<std::string> libraries;
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension != ".obj") return libraries;
+    MappedFile source(path);
+    auto begin = reinterpret_cast<const char *>(source.data());
+    auto end = begin + source.size();
+    for (const char *line = begin; line < end;) {
+        auto line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (!line_end) line_end = end;
+        std::string_view text(line, line_end - line);
+        if (text.substr(0, 7) == "mtllib " || text.substr(0, 7) == "mtllib\t") {
+            // the rest of the line, like the OBJ loader reads it
+            text.remove_prefix(7);
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+                text.remove_suffix(1);
+            }
+            if (!text.empty()) libraries.emplace_back(text);
+        }
+        line = line_end + 1;
+    }
+    return libraries;
+}
+
+// bounds checked cursor over the mapped cache file
+class CacheReader {
+   public:
+    CacheReader(const unsigned char *data, size_t size, size_t offset)
+        : data(data), size(size), offset(offset) {}
+
+    bool read(void *dst, size_t count) {
+        if (offset > size || count > size - offset) return false;
+        std::memcpy(dst, data + offset, count);
+        offset += count;
+        return true;
+    }
+
+    bool readString(std::string &str) {
+        uint32_t length;
+        if (!read(&length, sizeof(length))) return false;
+        if (offset > size || length > size - offset) return false;
+        str.assign(reinterpret_cast<const char *>(data + offset), length);
+        offset += length;
+        return true;
+    }
+
+    size_t position() const { return offset; }
+
+   private:
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+};
+
+class CacheWriter {
+   public:
+    void write(const void *src, size_t count) {
+        auto bytes = static_cast<const unsigned char *>(src);
+        buffer.insert(buffer.end(), bytes, bytes + count);
+    }
+
+    void writeString(const std::string &str) {
+        auto length = static_cast<uint32_t>(str.size());
+        write(&length, sizeof(length));
+        write(str.data(), str.size());
+    }
+
+    void align() { buffer.resize((buffer.size() + CACHE_ALIGNMENT - 1) & ~(CACHE_ALIGNMENT - 1)); }
+
+    size_t offset() const { return buffer.size(); }
+    unsigned char *at(size_t offset) { return buffer.data() + offset; }
+    const std::vector<unsigned char> &data() const { return buffer; }
+
+   private:
+    std::vector<unsigned char> buffer;
+};
+
+std::string MeshCache::cachePath(const std::string &source_path) {
+    return source_path + ".meshcache";
+}
+
+MeshCache::MeshCache(const std::string &source_path, unsigned int import_flags,
+                     unsigned int processing_flags)
+    : file(cachePath(source_path)) {
+    if (!file.isOpen()) return;
+
+    CacheHeader header;
+    CacheReader reader(file.data(), file.size(), 0);
+    if (!reader.read(&header, sizeof(header))) return;
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.vertex_size != sizeof(Vertex) ||
+        header.import_flags != import_flags || header.processing_flags != processing_flags) {
+        return;
+    }
+
+    // the model file and its material libraries must be the ones the cache was written from.
+    // The content hash is only needed when a file was touched without being changed, the new
+    // mtime is written back then so the next load doesn't hash it again.
+    std::string directory = source_path.substr(0, source_path.find_last_of('/') + 1);
+    std::vector<std::pair<size_t, int64_t>> touched;
+    for (uint32_t i = 0; i < header.num_sources; ++i) {
+        size_t record_offset = reader.position();
+        CacheSourceRecord record;
+        std::string name;
+        if (!reader.read(&record, sizeof(record)) || !reader.readString(name)) return;
+        std::string path = name.empty() ? source_path : directory + name;
+        SourceInfo source;
+        bool exists = getSourceInfo(path, source);
+        if (!exists || record.size == SOURCE_MISSING) {
+            if (exists || record.size != SOURCE_MISSING) return;
+            continue;
+        }
+        if (source.size != record.size) return;
+        if (source.mtime != record.mtime) {
+            if (hashSource(path) != record.hash) return;
+            touched.emplace_back(record_offset + offsetof(CacheSourceRecord, mtime), source.mtime);
+        }
+    }
+    if (!touched.empty()) {
+        std::fstream out(cachePath(source_path), std::ios::binary | std::ios::in | std::ios::out);
+        for (const auto &[offset, mtime] : touched) {
+            out.seekp(static_cast<std::streamoff>(offset));
+            out.write(reinterpret_cast<const char *>(&mtime), sizeof(mtime));
+        }
+    }
+
+    // the table of contents holds the offset and the name of every mesh record, so a subset of
+    // the meshes can be found without touching the other records
+    if (header.toc_offset > file.size() ||
+        header.num_meshes > (file.size() - header.toc_offset) / sizeof(uint64_t)) {
+        return;
+    }
+    CacheReader toc(file.data(), file.size(), header.toc_offset);
+    mesh_offsets.resize(header.num_meshes);
+    mesh_names.resize(header.num_meshes);
+    bool ok = toc.read(mesh_offsets.data(), mesh_offsets.size() * sizeof(uint64_t));
+    for (auto &name : mesh_names) {
+        ok = ok && toc.readString(name);
+    }
+    for (auto offset : mesh_offsets) {
+        ok = ok && offset + sizeof(CacheMeshRecord) <= file.size();
+    }
+    if (!ok) {
+        mesh_offsets.clear();
+        mesh_names.clear();
+        return;
+    }
+    partial = (header.flags & CACHE_PARTIAL) != 0;
+    valid = true;
+}
+
+MeshView MeshCache::mesh(size_t i) const {
+    MeshView mesh;
+    CacheMeshRecord record;
+    CacheReader reader(file.data(), file.size(), mesh_offsets.at(i));
+    bool ok = reader.read(&record, sizeof(record)) && reader.readString(mesh.name) &&
+              reader.readString(mesh.material.name);
+    mesh.textures.resize(ok ? record.num_textures : 0);
+    // roles are stored by name, so reordering TextureRole doesn't invalidate caches
+    std::string role;
+    for (auto &texture : mesh.textures) {
+        ok = ok && reader.readString(role) && parseTextureRole(role, texture.role) &&
+             reader.readString(texture.path);
+    }
+    ok = ok && record.num_lods <= file.size() / sizeof(CacheLodRecord);
+    mesh.lods.resize(ok ? record.num_lods : 0);
+    for (auto &lod : mesh.lods) {
+        CacheLodRecord lod_record{};
+        ok = ok && reader.read(&lod_record, sizeof(lod_record)) &&
+             lod_record.index_offset + lod_record.num_indices <= record.num_indices;
+        lod = MeshLod{lod_record.index_offset, lod_record.num_indices, lod_record.error};
+    }
+    ok = ok && record.num_meshlets <= file.size() / sizeof(Meshlet);
+    mesh.meshlets.resize(ok ? record.num_meshlets : 0);
+    ok = ok && reader.read(mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+    for (const auto &meshlet : mesh.meshlets) {
+        ok = ok && uint64_t(meshlet.index_offset) + meshlet.num_indices <= record.num_indices;
+    }
+    ok = ok && record.vertices_offset <= file.size() &&
+         record.num_vertices <= (file.size() - record.vertices_offset) / sizeof(Vertex) &&
+         record.indices_offset <= file.size() &&
+         record.num_indices <= (file.size() - record.indices_offset) / sizeof(unsigned int);
+    if (!ok) {
+        throw std::runtime_error("corrupted mesh cache record " + std::to_string(i));
+    }
+
+    mesh.material.color_ambient = glm::vec3(record.color_ambient[0], record.color_ambient[1],
+                                            record.color_ambient[2]);
+    mesh.material.color_diffuse = glm::vec3(record.color_diffuse[0], record.color_diffuse[1],
+                                            record.color_diffuse[2]);
+    mesh.material.color_specular = glm::vec3(record.color_specular[0], record.color_specular[1],
+                                             record.color_specular[2]);
+    mesh.material.shininess = record.shininess;
+    mesh.material.dissolve = record.dissolve;
+    mesh.material.refracti = record.refracti;
+    mesh.has_bones = record.has_bones != 0;
+    mesh.bounds.min = glm::vec3(record.bounds_min[0], record.bounds_min[1], record.bounds_min[2]);
+    mesh.bounds.max = glm::vec3(record.bounds_max[0], record.bounds_max[1], record.bounds_max[2]);
+    mesh.bounds.center =
+        glm::vec3(record.bounds_center[0], record.bounds_center[1], record.bounds_center[2]);
+    mesh.bounds.radius = record.bounds_radius;
+
+    mesh.vertices = reinterpret_cast<const Vertex *>(file.data() + record.vertices_offset);
+    mesh.num_vertices = record.num_vertices;
+    mesh.indices = reinterpret_cast<const unsigned int *>(file.data() + record.indices_offset);
+    mesh.num_indices = record.num_indices;
+    return mesh;
+}
+
+bool MeshCache::write(const std::string &source_path, unsigned int import_flags,
+                      unsigned int processing_flags, const std::vector<MeshData> &meshes,
+                      bool partial) {
+    SourceInfo source;
+    if (!getSourceInfo(source_path, source)) return false;
+    std::vector<std::string> sources = materialLibraries(source_path);
+    sources.insert(sources.begin(), std::string());
+    std::string directory = source_path.substr(0, source_path.find_last_of('/') + 1);
+
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.vertex_size = sizeof(Vertex);
+    header.import_flags = import_flags;
+    header.processing_flags = processing_flags;
+    header.num_meshes = static_cast<uint32_t>(meshes.size());
+    header.flags = partial ? CACHE_PARTIAL : 0;
+    header.num_sources = static_cast<uint32_t>(sources.size());
+
+    CacheWriter writer;
+    writer.write(&header, sizeof(header));
+    for (const auto &name : sources) {
+        std::string path = name.empty() ? source_path : directory + name;
+        CacheSourceRecord record{SOURCE_MISSING, 0, 0};
+        if (getSourceInfo(path, source)) {
+            record = CacheSourceRecord{source.size, source.mtime, hashSource(path)};
+        }
+        writer.write(&record, sizeof(record));
+        writer.writeString(name);
+    }
+
+    std::vector<uint64_t> mesh_offsets;
+    mesh_offsets.reserve(meshes.size());
+    for (const auto &mesh : meshes) {
+        writer.align();
+        mesh_offsets.push_back(writer.offset());
+
+        CacheMeshRecord record{};
+        record.num_vertices = mesh.vertices.size();
+        record.num_indices = mesh.indices.size();
+        for (int c = 0; c < 3; ++c) {
+            record.color_ambient[c] = mesh.material.color_ambient[c];
+            record.color_diffuse[c] = mesh.material.color_diffuse[c];
+            record.color_specular[c] = mesh.material.color_specular[c];
+            record.bounds_min[c] = mesh.bounds.min[c];
+            record.bounds_max[c] = mesh.bounds.max[c];
+            record.bounds_center[c] = mesh.bounds.center[c];
+        }
+        record.bounds_radius = mesh.bounds.radius;
+        record.shininess = mesh.material.shininess;
+        record.dissolve = mesh.material.dissolve;
+        record.refracti = mesh.material.refracti;
+        record.num_textures = static_cast<uint32_t>(mesh.textures.size());
+        record.has_bones = mesh.has_bones;
+        size_t record_offset = writer.offset();
+        writer.write(&record, sizeof(record));
+        writer.writeString(mesh.name);
+        writer.writeString(mesh.material.name);
+        for (const auto &texture : mesh.textures) {
+            writer.writeString(textureRoleName(texture.role));
+            writer.writeString(texture.path);
+        }
+        record.num_lods = static_cast<uint32_t>(mesh.lods.size());
+        for (const auto &lod : mesh.lods) {
+            CacheLodRecord lod_record{lod.index_offset, lod.num_indices, lod.error, 0};
+            writer.write(&lod_record, sizeof(lod_record));
+        }
+        record.num_meshlets = static_cast<uint32_t>(mesh.meshlets.size());
+        writer.write(mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+
+        writer.align();
+        record.vertices_offset = writer.offset();
+        writer.write(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+        writer.align();
+        record.indices_offset = writer.offset();
+        writer.write(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+        std::memcpy(writer.at(record_offset), &record, sizeof(record));
+    }
+
+    writer.align();
+    header.toc_offset = writer.offset();
+    writer.write(mesh_offsets.data(), mesh_offsets.size() * sizeof(uint64_t));
+    for (const auto &mesh : meshes) {
+        writer.writeString(mesh.name);
+    }
+    std::memcpy(writer.at(0), &header, sizeof(header));
+
+    // write to a temporary file first so a concurrently starting run never maps a partial cache
+    auto path = cachePath(source_path);
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(writer.data().data()),
+                  static_cast<std::streamsize>(writer.data().size()));
+        if (!out) {
+            std::cout << "ERROR::MESH_CACHE:: failed to write " << tmp_path << '\n';
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::cout << "ERROR::MESH_CACHE:: failed to write " << path << ": " << ec.message()
+                  << '\n';
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
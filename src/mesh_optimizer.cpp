@@ -0,0 +1,189 @@
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <limits>
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t num_vertices,
+                                    unsigned int cache_size) {
+    VertexCacheStats stats;
+    if (indices.size() < 3 || num_vertices == 0) return stats;
+
+    // a vertex is in the FIFO cache while fewer than cache_size misses happened since it was
+    // inserted
+    std::vector<size_t> inserted(num_vertices, 0);
+    size_t misses = 0;
+    for (auto index : indices) {
+        if (inserted[index] == 0 || misses - inserted[index] >= cache_size) {
+            ++misses;
+            inserted[index] = misses;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / num_vertices;
+    return stats;
+}
+
+std::vector<size_t> optimizeVertexCache(std::vector<unsigned int> &indices, size_t num_vertices,
+                                        unsigned int cache_size) {
+    std::vector<size_t> clusters;
+    size_t num_triangles = indices.size() / 3;
+    if (num_triangles == 0) return clusters;
+
+    // triangles adjacent to each vertex, as offsets into one array
+    std::vector<unsigned int> live(num_vertices, 0);
+    for (auto index : indices) ++live[index];
+    std::vector<size_t> adjacency_offsets(num_vertices + 1, 0);
+    for (size_t v = 0; v < num_vertices; ++v) {
+        adjacency_offsets[v + 1] = adjacency_offsets[v] + live[v];
+    }
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<bool> emitted(num_triangles, false);
+    std::vector<size_t> cache_time(num_vertices, 0);
+    std::vector<unsigned int> dead_end;
+    size_t time = cache_size + 1;
+    size_t cursor = 0;
+    long fanning = indices[0];
+
+    clusters.push_back(0);
+    while (fanning >= 0) {
+        // emit all remaining triangles around the fanning vertex
+        std::vector<unsigned int> candidates;
+        for (size_t a = adjacency_offsets[fanning]; a < adjacency_offsets[fanning + 1]; ++a) {
+            unsigned int triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = true;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[triangle * 3 + k];
+                result.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - cache_time[v] > cache_size) {
+                    cache_time[v] = time++;
+                }
+            }
+        }
+
+        // next fanning vertex: the candidate staying in the cache the longest while all its
+        // triangles are emitted
+        fanning = -1;
+        size_t best_priority = 0;
+        for (auto v : candidates) {
+            if (live[v] == 0) continue;
+            size_t priority = 0;
+            if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+                priority = time - cache_time[v];
+            }
+            if (fanning < 0 || priority > best_priority) {
+                fanning = v;
+                best_priority = priority;
+            }
+        }
+        if (fanning >= 0) continue;
+
+        // otherwise the most recent vertex with triangles left, or the next one in input order.
+        // The order jumps here, so a new cluster starts.
+        while (!dead_end.empty() && fanning < 0) {
+            unsigned int v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0) fanning = v;
+        }
+        while (fanning < 0 && cursor < num_vertices) {
+            if (live[cursor] > 0) fanning = static_cast<long>(cursor);
+            ++cursor;
+        }
+        if (fanning >= 0 && result.size() != clusters.back()) {
+            clusters.push_back(result.size());
+        }
+    }
+
+    indices.swap(result);
+    return clusters;
+}
+
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                      const std::vector<size_t> &clusters) {
+    if (clusters.size() < 2) return;
+
+    // area weighted centroid and normal of each cluster and of the whole mesh
+    struct Cluster {
+        size_t begin;
+        size_t end;
+        float sort_key;
+    };
+    std::vector<Cluster> sorted;
+    std::vector<glm::vec3> centroids;
+    std::vector<glm::vec3> normals;
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        size_t begin = clusters[c];
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : indices.size();
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t i = begin; i < end; i += 3) {
+            const glm::vec3 &p0 = vertices[indices[i]].Position;
+            const glm::vec3 &p1 = vertices[indices[i + 1]].Position;
+            const glm::vec3 &p2 = vertices[indices[i + 2]].Position;
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float triangle_area = glm::length(cross);
+            centroid += (p0 + p1 + p2) * (triangle_area / 3.0f);
+            normal += cross;
+            area += triangle_area;
+        }
+        mesh_centroid += centroid;
+        mesh_area += area;
+        centroids.push_back(area > 0.0f ? centroid / area : centroid);
+        float length = glm::length(normal);
+        normals.push_back(length > 0.0f ? normal / length : normal);
+        sorted.push_back(Cluster{begin, end, 0.0f});
+    }
+    if (mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+    // clusters far out along their normal are likely in front of the others from any viewpoint
+    for (size_t c = 0; c < sorted.size(); ++c) {
+        sorted[c].sort_key = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const auto &cluster : sorted) {
+        result.insert(result.end(), indices.begin() + cluster.begin,
+                      indices.begin() + cluster.end);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices) {
+    const unsigned int unused = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (auto &index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<unsigned int>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+std::pair<VertexCacheStats, VertexCacheStats> optimizeMesh(MeshData &mesh) {
+    VertexCacheStats before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    auto clusters = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+    optimizeVertexFetch(mesh.vertices, mesh.indices);
+    VertexCacheStats after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    return {before, after};
+}
\ No newline at end of file
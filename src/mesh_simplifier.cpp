@@ -0,0 +1,355 @@
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+// symmetric 4x4 matrix measuring the squared distance to a set of planes
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    // sum of the plane weights
+    double weight = 0;
+
+    void addPlane(const glm::dvec3 &n, double d, double w) {
+        a00 += w * n.x * n.x;
+        a01 += w * n.x * n.y;
+        a02 += w * n.x * n.z;
+        a03 += w * n.x * d;
+        a11 += w * n.y * n.y;
+        a12 += w * n.y * n.z;
+        a13 += w * n.y * d;
+        a22 += w * n.z * n.z;
+        a23 += w * n.z * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &q) {
+        a00 += q.a00, a01 += q.a01, a02 += q.a02, a03 += q.a03;
+        a11 += q.a11, a12 += q.a12, a13 += q.a13;
+        a22 += q.a22, a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    double error(const glm::vec3 &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x + a11 * y * y +
+                   2 * a12 * y * z + 2 * a13 * y + a22 * z * z + 2 * a23 * z + a33;
+        return std::max(e, 0.0);
+    }
+
+    // weighted mean of the squared distances of p to the planes. error() alone grows with the
+    // area around the vertex, this is a squared distance in the units of the positions.
+    double meanError(const glm::vec3 &p) const { return weight > 0.0 ? error(p) / weight : 0.0; }
+};
+
+struct PositionHash {
+    size_t operator()(const glm::vec3 &p) const {
+        uint32_t bits[3];
+        std::memcpy(bits, &p, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+// the attributes that show on screen: position, normal and texture coordinates. Vertices equal in
+// all of them are interchangeable, the simplified mesh uses the first one (and its tangents).
+static constexpr size_t NUM_ATTRIBUTE_FLOATS = 8;
+
+static void attributeBits(const Vertex &vertex, uint32_t (&bits)[NUM_ATTRIBUTE_FLOATS]) {
+    std::memcpy(bits, &vertex.Position, 12);
+    std::memcpy(bits + 3, &vertex.Normal, 12);
+    std::memcpy(bits + 6, &vertex.TexCoords, 8);
+}
+
+struct AttributeHash {
+    const std::vector<Vertex> *vertices;
+
+    size_t operator()(unsigned int v) const {
+        uint32_t bits[NUM_ATTRIBUTE_FLOATS];
+        attributeBits((*vertices)[v], bits);
+        size_t hash = 0;
+        for (auto b : bits) hash = hash * 31 + b;
+        return hash;
+    }
+};
+
+struct AttributeEqual {
+    const std::vector<Vertex> *vertices;
+
+    bool operator()(unsigned int a, unsigned int b) const {
+        uint32_t bits_a[NUM_ATTRIBUTE_FLOATS], bits_b[NUM_ATTRIBUTE_FLOATS];
+        attributeBits((*vertices)[a], bits_a);
+        attributeBits((*vertices)[b], bits_b);
+        return std::memcmp(bits_a, bits_b, sizeof(bits_a)) == 0;
+    }
+};
+
+// an edge of the mesh, collapsing moves the position group of from onto the one of to
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+// false if moving vertex from onto vertex to flips or degenerates a triangle around from
+static bool collapseKeepsOrientation(const std::vector<Vertex> &vertices,
+                                     const std::vector<unsigned int> &indices,
+                                     const std::vector<size_t> &adjacency_offsets,
+                                     const std::vector<unsigned int> &adjacency, unsigned int from,
+                                     unsigned int to) {
+    const glm::vec3 &target = vertices[to].Position;
+    for (size_t a = adjacency_offsets[from]; a < adjacency_offsets[from + 1]; ++a) {
+        const unsigned int *triangle = &indices[adjacency[a] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+        glm::vec3 p[3], q[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = vertices[triangle[k]].Position;
+            q[k] = triangle[k] == from ? target : p[k];
+        }
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// pairs every vertex of members that is still used with the one vertex of to_group it shares
+// triangles with, in moves. Fails if a vertex shares triangles with none or several vertices of
+// to_group, or two vertices with the same one: then the seam through the group doesn't run along
+// the collapsed edge, and moving the group would stretch texture space across it.
+static bool matchGroupCollapse(const std::vector<unsigned int> &group,
+                               const std::vector<unsigned int> &indices,
+                               const std::vector<size_t> &adjacency_offsets,
+                               const std::vector<unsigned int> &adjacency,
+                               const unsigned int *members, size_t num_members,
+                               unsigned int to_group,
+                               std::vector<std::pair<unsigned int, unsigned int>> &moves) {
+    moves.clear();
+    for (size_t m = 0; m < num_members; ++m) {
+        unsigned int from = members[m];
+        if (adjacency_offsets[from] == adjacency_offsets[from + 1]) continue;
+        unsigned int to = std::numeric_limits<unsigned int>::max();
+        for (size_t a = adjacency_offsets[from]; a < adjacency_offsets[from + 1]; ++a) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[adjacency[a] * 3 + k];
+                if (group[v] != to_group || v == to) continue;
+                if (to != std::numeric_limits<unsigned int>::max()) return false;
+                to = v;
+            }
+        }
+        if (to == std::numeric_limits<unsigned int>::max()) return false;
+        for (const auto &move : moves) {
+            if (move.second == to) return false;
+        }
+        moves.emplace_back(from, to);
+    }
+    return !moves.empty();
+}
+
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex> &vertices,
+                                       const std::vector<unsigned int> &indices,
+                                       size_t target_index_count, float target_error,
+                                       float *result_error) {
+    double max_error = 0.0;
+    auto num_vertices = static_cast<unsigned int>(vertices.size());
+
+    // duplicates of a vertex (unindexed input, or an importer that didn't join them) are replaced
+    // by the first one, so only real seams split a position into several vertices
+    std::vector<unsigned int> canonical(num_vertices);
+    std::unordered_map<unsigned int, unsigned int, AttributeHash, AttributeEqual> unique(
+        num_vertices, AttributeHash{&vertices}, AttributeEqual{&vertices});
+    for (unsigned int v = 0; v < num_vertices; ++v) {
+        canonical[v] = unique.emplace(v, v).first->second;
+    }
+    std::vector<unsigned int> result(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) result[i] = canonical[indices[i]];
+
+    // vertices sharing a position (split for different UVs or normals) form one position group,
+    // named by its first vertex. The members of group g are
+    // group_members[group_offsets[g], group_offsets[g + 1]).
+    std::vector<unsigned int> group(num_vertices);
+    std::vector<size_t> group_offsets(num_vertices + 1, 0);
+    std::unordered_map<glm::vec3, unsigned int, PositionHash> groups;
+    glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+    for (unsigned int v = 0; v < num_vertices; ++v) {
+        group[v] = groups.emplace(vertices[v].Position, v).first->second;
+        if (canonical[v] == v) ++group_offsets[group[v] + 1];
+        min = glm::min(min, vertices[v].Position);
+        max = glm::max(max, vertices[v].Position);
+    }
+    for (unsigned int v = 0; v < num_vertices; ++v) group_offsets[v + 1] += group_offsets[v];
+    std::vector<unsigned int> group_members(group_offsets[num_vertices]);
+    {
+        std::vector<size_t> fill(group_offsets.begin(), group_offsets.end() - 1);
+        for (unsigned int v = 0; v < num_vertices; ++v) {
+            if (canonical[v] == v) group_members[fill[group[v]]++] = v;
+        }
+    }
+    float extent = std::max(std::max(max.x - min.x, max.y - min.y), max.z - min.z);
+    double error_limit = static_cast<double>(target_error) * extent;
+    error_limit *= error_limit;
+
+    // groups on edges used by only one triangle stay where they are, which keeps the outline of
+    // open surfaces
+    std::vector<bool> locked(num_vertices, false);
+    std::unordered_map<uint64_t, int> edges;
+    auto edgeKey = [](unsigned int a, unsigned int b) { return (uint64_t(a) << 32) | b; };
+    for (size_t i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            unsigned int a = group[result[i + k]], b = group[result[i + (k + 1) % 3]];
+            ++edges[edgeKey(a, b)];
+        }
+    }
+    for (size_t i = 0; i < result.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            unsigned int a = group[result[i + k]], b = group[result[i + (k + 1) % 3]];
+            if (edges.count(edgeKey(b, a)) == 0) locked[a] = locked[b] = true;
+        }
+    }
+
+    // the quadric of a position group sums the planes of all triangles around it, weighted by
+    // their area
+    std::vector<Quadric> quadrics(num_vertices);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        glm::dvec3 p0 = vertices[result[i]].Position;
+        glm::dvec3 p1 = vertices[result[i + 1]].Position;
+        glm::dvec3 p2 = vertices[result[i + 2]].Position;
+        glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(normal);
+        if (area == 0.0) continue;
+        normal /= area;
+        for (int k = 0; k < 3; ++k) {
+            quadrics[group[result[i + k]]].addPlane(normal, -glm::dot(normal, p0), area);
+        }
+    }
+
+    std::vector<size_t> adjacency_offsets(num_vertices + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<unsigned int> collapse_to(num_vertices);
+    std::vector<bool> touched(num_vertices);
+    std::vector<Collapse> collapses;
+    std::vector<std::pair<unsigned int, unsigned int>> moves;
+    while (result.size() > target_index_count) {
+        // triangles around each vertex
+        std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+        for (auto index : result) ++adjacency_offsets[index + 1];
+        for (size_t v = 0; v < num_vertices; ++v) {
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+            adjacency[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        // every edge can move a group that isn't locked onto the group at its other end
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                if (group[a] == group[b]) continue;
+                for (int direction = 0; direction < 2; ++direction, std::swap(a, b)) {
+                    if (locked[group[a]]) continue;
+                    Quadric q = quadrics[group[a]];
+                    q.add(quadrics[group[b]]);
+                    collapses.push_back(Collapse{a, b, q.meanError(vertices[b].Position)});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+        // apply the cheapest collapses that don't overlap, each removes about two triangles
+        size_t triangles_to_remove = (result.size() - target_index_count) / 3;
+        size_t max_collapses = triangles_to_remove / 2 + 1;
+        size_t num_collapses = 0;
+        for (unsigned int v = 0; v < num_vertices; ++v) collapse_to[v] = v;
+        std::fill(touched.begin(), touched.end(), false);
+        for (const auto &collapse : collapses) {
+            if (collapse.cost > error_limit || num_collapses == max_collapses) break;
+            unsigned int from_group = group[collapse.from], to_group = group[collapse.to];
+            if (touched[from_group] || touched[to_group]) continue;
+            // every vertex of the group moves to its counterpart on the same side of the seams
+            if (!matchGroupCollapse(group, result, adjacency_offsets, adjacency,
+                                    &group_members[group_offsets[from_group]],
+                                    group_offsets[from_group + 1] - group_offsets[from_group],
+                                    to_group, moves)) {
+                continue;
+            }
+            bool keeps_orientation = true;
+            for (size_t m = 0; m < moves.size() && keeps_orientation; ++m) {
+                keeps_orientation = collapseKeepsOrientation(vertices, result, adjacency_offsets,
+                                                             adjacency, moves[m].first,
+                                                             moves[m].second);
+            }
+            if (!keeps_orientation) continue;
+
+            quadrics[to_group].add(quadrics[from_group]);
+            max_error = std::max(max_error, collapse.cost);
+            ++num_collapses;
+            // the triangles around the collapsed group change, so none of their vertices may be
+            // part of another collapse in this pass
+            for (const auto &move : moves) {
+                collapse_to[move.first] = move.second;
+                for (size_t a = adjacency_offsets[move.first];
+                     a < adjacency_offsets[move.first + 1]; ++a) {
+                    for (int k = 0; k < 3; ++k) touched[group[result[adjacency[a] * 3 + k]]] = true;
+                }
+            }
+        }
+        if (num_collapses == 0) break;
+
+        // remap the indices and drop the triangles that collapsed
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned int a = collapse_to[result[i]];
+            unsigned int b = collapse_to[result[i + 1]];
+            unsigned int c = collapse_to[result[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (result_error) {
+        *result_error = extent > 0.0f ? static_cast<float>(std::sqrt(max_error)) / extent : 0.0f;
+    }
+    return result;
+}
+
+void generateLods(MeshData &mesh, size_t max_lods, float max_error) {
+    mesh.lods.clear();
+    mesh.lods.push_back(MeshLod{0, mesh.indices.size(), 0.0f});
+
+    std::vector<unsigned int> current = mesh.indices;
+    float error = 0.0f;
+    while (mesh.lods.size() < max_lods) {
+        size_t target = current.size() / 6 * 3;
+        float lod_error = 0.0f;
+        std::vector<unsigned int> lod =
+            simplifyMesh(mesh.vertices, current, target, max_error - error, &lod_error);
+        // stop when the seams or the error limit leave little to simplify
+        if (lod.empty() || lod.size() > current.size() * 85 / 100) break;
+
+        // every level is simplified from the previous one, so the errors add up
+        error += lod_error;
+        optimizeVertexCache(lod, mesh.vertices.size());
+        mesh.lods.push_back(MeshLod{mesh.indices.size(), lod.size(), error});
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        current = std::move(lod);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <learnopengl/mesh.h>
+#include <learnopengl/meshlet.h>
+
+#include <algorithm>
+#include <cmath>
+
+// fills the bounds and the normal cone of a meshlet whose index range is set
+static void computeMeshletBounds(Meshlet &meshlet, const std::vector<Vertex> &vertices,
+                                 const std::vector<unsigned int> &indices) {
+    size_t begin = meshlet.index_offset, end = begin + meshlet.num_indices;
+    glm::vec3 min = vertices[indices[begin]].Position, max = min;
+    for (size_t i = begin; i < end; ++i) {
+        min = glm::min(min, vertices[indices[i]].Position);
+        max = glm::max(max, vertices[indices[i]].Position);
+    }
+    meshlet.center = (min + max) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (size_t i = begin; i < end; ++i) {
+        meshlet.radius =
+            std::max(meshlet.radius, glm::length(vertices[indices[i]].Position - meshlet.center));
+    }
+
+    std::vector<glm::vec3> normals;
+    glm::vec3 axis(0.0f);
+    for (size_t i = begin; i < end; i += 3) {
+        const glm::vec3 &p0 = vertices[indices[i]].Position;
+        const glm::vec3 &p1 = vertices[indices[i + 1]].Position;
+        const glm::vec3 &p2 = vertices[indices[i + 2]].Position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f) continue;
+        normals.push_back(normal / length);
+        axis += normals.back();
+    }
+    float axis_length = glm::length(axis);
+    if (normals.empty() || axis_length == 0.0f) return;
+    meshlet.cone_axis = axis / axis_length;
+
+    // the smallest cosine between the axis and a normal gives the half angle of the cone, a
+    // cone of 90 degrees or more can't be culled
+    float min_dot = 1.0f;
+    for (const auto &normal : normals) {
+        min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+    }
+    meshlet.cone_cutoff = min_dot <= 0.0f ? 1.0f : std::sqrt(1.0f - min_dot * min_dot);
+}
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex> &vertices,
+                                   const std::vector<unsigned int> &indices, size_t num_indices,
+                                   size_t max_vertices, size_t max_triangles) {
+    std::vector<Meshlet> meshlets;
+    // meshlet each vertex was last added to, to count the unique vertices of the current one
+    std::vector<size_t> used_by(vertices.size(), SIZE_MAX);
+    Meshlet meshlet;
+    size_t num_vertices = 0;
+    for (size_t i = 0; i + 2 < num_indices; i += 3) {
+        size_t new_vertices = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (used_by[indices[i + k]] != meshlets.size()) ++new_vertices;
+        }
+        if (meshlet.num_indices > 0 && (num_vertices + new_vertices > max_vertices ||
+                                        meshlet.num_indices / 3 + 1 > max_triangles)) {
+            computeMeshletBounds(meshlet, vertices, indices);
+            meshlets.push_back(meshlet);
+            meshlet = Meshlet();
+            meshlet.index_offset = static_cast<uint32_t>(i);
+            num_vertices = 0;
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (used_by[indices[i + k]] != meshlets.size()) {
+                used_by[indices[i + k]] = meshlets.size();
+                ++num_vertices;
+            }
+        }
+        meshlet.num_indices += 3;
+    }
+    if (meshlet.num_indices > 0) {
+        computeMeshletBounds(meshlet, vertices, indices);
+        meshlets.push_back(meshlet);
+    }
+    return meshlets;
+}
\ No newline at end of file
@@ -1,59 +1,528 @@
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+#include <learnopengl/meshlet.h>
 #include <learnopengl/model.h>
+#include <learnopengl/obj_loader.h>
+#include <learnopengl/texture_array.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <tuple>
+#include <unordered_set>
+
+// post processing of ImportPreset::Exact, the other presets remove or add steps. The flags are
+// part of the mesh cache key, so changing them invalidates the caches of that preset.
+static const unsigned int EXACT_IMPORT_FLAGS = aiProcess_Triangulate |
+                                               aiProcess_GenSmoothNormals | aiProcess_FlipUVs |
+                                               aiProcess_CalcTangentSpace;
+
+const char *importPresetName(ImportPreset preset) {
+    switch (preset) {
+        case ImportPreset::FastPreview:
+            return "fast-preview";
+        case ImportPreset::RuntimeOptimized:
+            return "runtime-optimized";
+        case ImportPreset::Exact:
+            return "exact";
+    }
+    return "unknown";
+}
+
+bool parseImportPreset(const std::string &name, ImportPreset &preset) {
+    for (ImportPreset candidate :
+         {ImportPreset::FastPreview, ImportPreset::RuntimeOptimized, ImportPreset::Exact}) {
+        if (name == importPresetName(candidate)) {
+            preset = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned int importFlags(ImportPreset preset) {
+    switch (preset) {
+        case ImportPreset::FastPreview:
+            return aiProcess_Triangulate | aiProcess_GenNormals | aiProcess_FlipUVs;
+        case ImportPreset::RuntimeOptimized:
+            return EXACT_IMPORT_FLAGS | aiProcess_JoinIdenticalVertices |
+                   aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes |
+                   aiProcess_OptimizeGraph | aiProcess_RemoveRedundantMaterials;
+        case ImportPreset::Exact:
+            break;
+    }
+    return EXACT_IMPORT_FLAGS;
+}
+
+// the steps of the Assimp flags of preset that loadObj does as well, so both import the same
+// meshes
+static ObjLoadOptions objLoadOptions(ImportPreset preset) {
+    unsigned int flags = importFlags(preset);
+    ObjLoadOptions obj;
+    obj.join_vertices = (flags & aiProcess_JoinIdenticalVertices) != 0;
+    obj.smooth_normals = (flags & aiProcess_GenSmoothNormals) != 0;
+    obj.tangents = (flags & aiProcess_CalcTangentSpace) != 0;
+    return obj;
+}
+
+// processing flags of the mesh cache: bit 0 is set for optimized meshes, bit 1 for meshes split
+// into meshlets, bit 2 when OBJ files are read by the native parser, bits 8-15 hold the LOD count
+// and bits 16-31 the LOD error limit in 1/65536ths of the mesh extent
+static const unsigned int PROCESSING_OPTIMIZED = 1;
+static const unsigned int PROCESSING_MESHLETS = 2;
+static const unsigned int PROCESSING_NATIVE_OBJ = 4;
+
+static unsigned int processingFlags(const ModelLoadOptions &options) {
+    unsigned int flags = options.optimize ? PROCESSING_OPTIMIZED : 0;
+    if (options.build_meshlets) flags |= PROCESSING_MESHLETS;
+    if (options.native_obj) flags |= PROCESSING_NATIVE_OBJ;
+    if (options.max_lods > 1) {
+        flags |= static_cast<unsigned int>(std::min<size_t>(options.max_lods, 255)) << 8;
+        flags |= static_cast<unsigned int>(glm::clamp(options.max_lod_error, 0.0f, 0.99f) * 65536)
+                 << 16;
+    }
+    return flags;
+}
+
+// optimizes an imported mesh and builds its LODs and meshlets as the options ask, then computes
+// its bounds
+static void finishMesh(MeshData &data, const ModelLoadOptions &options, std::ostringstream &log) {
+    if (options.optimize) {
+        auto [before, after] = optimizeMesh(data);
+        log << "optimized: ACMR " << before.acmr << " -> " << after.acmr << ", ATVR "
+            << before.atvr << " -> " << after.atvr << '\n';
+    }
+    if (options.max_lods > 1) {
+        generateLods(data, options.max_lods, options.max_lod_error);
+        log << "lods:";
+        for (const auto &lod : data.lods) {
+            log << ' ' << lod.num_indices / 3 << " (" << lod.error << ')';
+        }
+        log << '\n';
+    }
+    if (options.build_meshlets) {
+        size_t num_indices = data.lods.empty() ? data.indices.size() : data.lods[0].num_indices;
+        data.meshlets = buildMeshlets(data.vertices, data.indices, num_indices);
+        log << "meshlets: " << data.meshlets.size() << '\n';
+    }
+
+    // the optimizer drops unused vertices, so the bounds are computed last
+    data.bounds = computeBounds(data.vertices.data(), data.vertices.size());
+    const Bounds &b = data.bounds;
+    log << "min: " << b.min.x << ' ' << b.min.y << ' ' << b.min.z << " max: " << b.max.x << ' '
+        << b.max.y << ' ' << b.max.z << " radius: " << b.radius << '\n';
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+static bool isMeshRequested(const std::vector<std::string> &mesh_names, const std::string &name) {
+    return mesh_names.empty() ||
+           std::find(mesh_names.begin(), mesh_names.end(), name) != mesh_names.end();
+}
+
+// remaps the mesh indices of node and its children, dropping the ones of deleted meshes
+static void pruneNode(aiNode *node, const std::vector<unsigned int> &remap) {
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
+        unsigned int index = remap[node->mMeshes[i]];
+        if (index != std::numeric_limits<unsigned int>::max()) node->mMeshes[kept++] = index;
+    }
+    node->mNumMeshes = kept;
+    for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+        pruneNode(node->mChildren[i], remap);
+    }
+}
+
+// deletes the meshes of scene that aren't in mesh_names, so post processing skips them
+static void pruneScene(aiScene *scene, const std::vector<std::string> &mesh_names) {
+    std::vector<unsigned int> remap(scene->mNumMeshes, std::numeric_limits<unsigned int>::max());
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+        aiMesh *mesh = scene->mMeshes[i];
+        if (isMeshRequested(mesh_names, mesh->mName.C_Str())) {
+            remap[i] = kept;
+            scene->mMeshes[kept++] = mesh;
+        } else {
+            delete mesh;
+        }
+    }
+    scene->mNumMeshes = kept;
+    pruneNode(scene->mRootNode, remap);
+}
+
+Model::~Model() { releaseTextures(); }
+
+Model::Model(Model &&other) noexcept
+    : textures_loaded(std::move(other.textures_loaded)),
+      meshes(std::move(other.meshes)),
+      directory(std::move(other.directory)),
+      gammaCorrection(other.gammaCorrection),
+      bounds(other.bounds),
+      geometry(std::move(other.geometry)),
+      textures_loaded_index(std::move(other.textures_loaded_index)),
+      texture_arrays(std::move(other.texture_arrays)) {
+    other.textures_loaded.clear();
+    other.textures_loaded_index.clear();
+    other.texture_arrays.clear();
+}
+
+Model &Model::operator=(Model &&other) noexcept {
+    if (this != &other) {
+        releaseTextures();
+        textures_loaded = std::move(other.textures_loaded);
+        meshes = std::move(other.meshes);
+        directory = std::move(other.directory);
+        gammaCorrection = other.gammaCorrection;
+        bounds = other.bounds;
+        geometry = std::move(other.geometry);
+        textures_loaded_index = std::move(other.textures_loaded_index);
+        texture_arrays = std::move(other.texture_arrays);
+        other.textures_loaded.clear();
+        other.textures_loaded_index.clear();
+        other.texture_arrays.clear();
+    }
+    return *this;
+}
+
+void Model::releaseTextures() {
+    TextureCache &cache = TextureCache::global();
+    for (const auto &texture : textures_loaded) cache.release(texture.id);
+    for (auto array : texture_arrays) cache.release(array);
+    textures_loaded.clear();
+    textures_loaded_index.clear();
+    texture_arrays.clear();
+}
 
 void Model::Draw(Shader &shader) const {
-    for (unsigned int i = 0; i < meshes.size(); i++) {
-        meshes[i].Draw(shader);
+    // the meshes share a VAO per vertex layout, GLState only binds it when the layout changes
+    for (unsigned int i = 0; i < meshes.size(); i++) meshes[i].Draw(shader);
+}
+
+size_t Model::residentBytes() const {
+    size_t bytes = meshes.capacity() * sizeof(Mesh);
+    for (const auto &mesh : meshes) {
+        bytes += mesh.residentBytes();
+    }
+    return bytes;
+}
+
+void Model::loadModel(std::string const &path, const std::vector<std::string> &mesh_names,
+                      const ModelLoadOptions &options) {
+    // the textures are decoded up front on the pool, then uploaded in mesh order
+    ModelData data = loadData(path, mesh_names, options, options.parallel);
+    size_t unlimited = std::numeric_limits<size_t>::max();
+    uploadStep(data, unlimited);
+}
+
+ModelData Model::loadData(std::string const &path, const std::vector<std::string> &mesh_names,
+                          const ModelLoadOptions &options, bool decode_textures) {
+    ModelData data;
+    data.path = path;
+    data.vertex_format = options.vertex_format;
+    data.cpu_residency = options.cpu_residency;
+    data.geometry_buffer = options.geometry_buffer;
+    data.texture_arrays = options.texture_arrays;
+    // retrieve the directory path of the filepath
+    data.directory = path.substr(0, path.find_last_of('/'));
+
+    std::vector<std::string> cached_names;
+    auto start = std::chrono::steady_clock::now();
+    data.timings.from_cache =
+        options.use_cache && loadFromCache(data, mesh_names, options, cached_names);
+    data.timings.import_ms = millisecondsSince(start);
+    if (!data.timings.from_cache) {
+        // a partial cache is rewritten with the meshes it already held plus the requested ones
+        std::vector<std::string> import_names = mesh_names;
+        bool subset = !mesh_names.empty();
+        for (const auto &name : cached_names) {
+            if (subset && !isMeshRequested(import_names, name)) import_names.push_back(name);
+        }
+
+        std::vector<MeshData> &meshes_data = data.imported;
+        start = std::chrono::steady_clock::now();
+        if (options.native_obj && options.import_preset != ImportPreset::RuntimeOptimized &&
+            isObjFile(path) &&
+            loadObj(path, import_names, options.parallel,
+                    objLoadOptions(options.import_preset), meshes_data)) {
+            data.timings.import_ms += millisecondsSince(start);
+            start = std::chrono::steady_clock::now();
+            auto finish = [&](size_t i) {
+                std::ostringstream log;
+                log << "mesh: " << meshes_data[i].name
+                    << ": verts: " << meshes_data[i].vertices.size() << '\n';
+                log << "material: " << meshes_data[i].material.name << '\n';
+                finishMesh(meshes_data[i], options, log);
+                std::cout << log.str();
+            };
+            if (options.parallel) {
+                ThreadPool::global().parallelFor(meshes_data.size(), finish);
+            } else {
+                for (size_t i = 0; i < meshes_data.size(); ++i) finish(i);
+            }
+            data.timings.convert_ms = millisecondsSince(start);
+        } else {
+            // a rejected file still counts as import time
+            data.timings.import_ms += millisecondsSince(start);
+            meshes_data.clear();
+            importMeshes(path, import_names, options, meshes_data, data.timings);
+        }
+        if (options.use_cache) {
+            start = std::chrono::steady_clock::now();
+            MeshCache::write(path, importFlags(options.import_preset), processingFlags(options),
+                             meshes_data, subset);
+            data.timings.cache_write_ms = millisecondsSince(start);
+        }
+
+        meshes_data.erase(std::remove_if(meshes_data.begin(), meshes_data.end(),
+                                         [&](const MeshData &mesh) {
+                                             return !isMeshRequested(mesh_names, mesh.name);
+                                         }),
+                          meshes_data.end());
+        data.meshes.reserve(meshes_data.size());
+        for (const auto &mesh : meshes_data) {
+            data.meshes.emplace_back(mesh);
+        }
+    }
+
+    for (const auto &mesh : data.meshes) {
+        data.num_vertices += mesh.num_vertices;
+        data.num_indices += mesh.lods.empty() ? mesh.num_indices : mesh.lods[0].num_indices;
     }
+    std::cout << path << ": " << importPresetName(options.import_preset) << ": "
+              << data.meshes.size() << " meshes, " << data.num_vertices << " vertices, "
+              << data.num_indices << " indices, import " << data.timings.import_ms
+              << " ms, convert " << data.timings.convert_ms << " ms"
+              << (data.timings.from_cache ? " (mesh cache)" : "") << '\n';
+
+    if (decode_textures) {
+        start = std::chrono::steady_clock::now();
+        std::unordered_set<std::string> seen;
+        std::vector<std::string> texture_names;
+        std::vector<std::string> texture_paths;
+        for (const auto &mesh : data.meshes) {
+            for (const auto &ref : mesh.textures) {
+                // textures another model already uploaded are shared instead of decoded again
+                std::string texture_path = data.directory + '/' + ref.path;
+                if (seen.insert(ref.path).second &&
+                    !TextureCache::global().contains(texture_path)) {
+                    texture_names.push_back(ref.path);
+                    texture_paths.push_back(std::move(texture_path));
+                }
+            }
+        }
+        // all textures of the model decode concurrently
+        std::vector<ImageData> images = options.parallel ? decodeImages(texture_paths)
+                                                         : std::vector<ImageData>();
+        for (size_t i = 0; i < texture_names.size(); ++i) {
+            data.images.emplace(texture_names[i], options.parallel ? std::move(images[i])
+                                                                   : decodeImage(texture_paths[i]));
+        }
+        data.timings.decode_ms = millisecondsSince(start);
+    }
+    return data;
 }
 
-void Model::loadModel(std::string const &path, const std::vector<std::string> &mesh_names) {
-    // read file via ASSIMP
+void Model::importMeshes(std::string const &path, const std::vector<std::string> &import_names,
+                         const ModelLoadOptions &options, std::vector<MeshData> &meshes_data,
+                         ModelLoadTimings &timings) {
+    // read file via ASSIMP. For a subset of the meshes the file is read without post processing,
+    // so normals and tangents are only generated for the meshes that are kept.
+    bool subset = !import_names.empty();
+    auto start = std::chrono::steady_clock::now();
     Assimp::Importer importer;
-    const aiScene *scene =
-        importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-                                    aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    unsigned int flags = importFlags(options.import_preset);
+    const aiScene *scene = importer.ReadFile(path, subset ? 0 : flags);
     // check for errors
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)  // if is Not Zero
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
+        !scene->mRootNode)  // if is Not Zero
     {
         std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
         throw std::runtime_error("ERROR::ASSIMP");
-        return;
     }
-    // retrieve the directory path of the filepath
-    directory = path.substr(0, path.find_last_of('/'));
+    if (subset) {
+        // the importer owns the scene, it is only modified before post processing
+        pruneScene(const_cast<aiScene *>(scene), import_names);
+        if (scene->mNumMeshes > 0) scene = importer.ApplyPostProcessing(flags);
+        if (!scene) {
+            std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+            throw std::runtime_error("ERROR::ASSIMP");
+        }
+    }
+
+    // process ASSIMP's root node recursively. Without a subset the cache keeps every mesh of the
+    // file, so it can serve any subset of them later.
+    std::vector<aiMesh *> ai_meshes;
+    processNode(scene->mRootNode, scene, import_names, ai_meshes);
+    timings.import_ms += millisecondsSince(start);
+
+    // every aiMesh is independent, so they are converted concurrently. Results are stored by
+    // index to keep the order deterministic.
+    start = std::chrono::steady_clock::now();
+    meshes_data.resize(ai_meshes.size());
+    auto convert = [&](size_t i) {
+        meshes_data[i] = processMesh(ai_meshes[i], scene, options);
+    };
+    if (options.parallel) {
+        ThreadPool::global().parallelFor(ai_meshes.size(), convert);
+    } else {
+        for (size_t i = 0; i < ai_meshes.size(); ++i) convert(i);
+    }
+    timings.convert_ms = millisecondsSince(start);
+}
+
+bool Model::loadFromCache(ModelData &data, const std::vector<std::string> &mesh_names,
+                          const ModelLoadOptions &options,
+                          std::vector<std::string> &cached_names) {
+    auto cache = std::make_unique<MeshCache>(data.path, importFlags(options.import_preset),
+                                             processingFlags(options));
+    if (!cache->isValid()) {
+        return false;
+    }
+
+    // a partial cache only serves requests for meshes it holds
+    if (cache->isPartial()) {
+        bool complete = !mesh_names.empty();
+        for (const auto &name : mesh_names) {
+            bool cached = false;
+            for (size_t i = 0; i < cache->size() && !cached; ++i) {
+                cached = cache->meshName(i) == name;
+            }
+            complete = complete && cached;
+        }
+        if (!complete) {
+            for (size_t i = 0; i < cache->size(); ++i) {
+                cached_names.push_back(cache->meshName(i));
+            }
+            return false;
+        }
+    }
+
+    try {
+        for (size_t i = 0; i < cache->size(); ++i) {
+            // the table of contents gives the names, so only requested records are parsed. The
+            // vertex/index data is later uploaded straight from the mapped file.
+            if (isMeshRequested(mesh_names, cache->meshName(i))) {
+                data.meshes.push_back(cache->mesh(i));
+            }
+        }
+    } catch (const std::runtime_error &e) {
+        std::cout << "ERROR::MESH_CACHE:: " << e.what() << ", reimporting " << data.path << '\n';
+        data.meshes.clear();
+        return false;
+    }
+    data.cache = std::move(cache);
+    return true;
+}
+
+bool Model::uploadStep(ModelData &data, size_t &budget_bytes) {
+    directory = data.directory;
+    // the scene keeps pointers to the meshes, so the vector must not grow after the upload
+    meshes.reserve(data.meshes.size());
+    if (!geometry) {
+        geometry = data.geometry_buffer ? data.geometry_buffer : std::make_shared<GeometryBuffer>();
+        // size the buffers for the whole model up front instead of growing them mesh by mesh
+        Mesh::reserveGeometry(*geometry, data.meshes, data.vertex_format);
+    }
+    while (data.next_mesh < data.meshes.size()) {
+        if (budget_bytes == 0) return false;
+        MeshView &mesh = data.meshes[data.next_mesh];
+        std::vector<Texture> textures;
+        if (!loadMaterialTextures(data, mesh.textures, budget_bytes, textures)) return false;
+        if (budget_bytes == 0) return false;
 
-    // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene, mesh_names);
+        meshes.emplace_back(mesh.name, mesh.vertices, mesh.num_vertices, mesh.indices,
+                            mesh.num_indices, std::move(textures), std::move(mesh.material),
+                            data.vertex_format, mesh.has_bones, std::move(mesh.lods),
+                            data.cpu_residency, &mesh.bounds, geometry.get());
+        meshes.back().setMeshlets(std::move(mesh.meshlets));
+        bounds.merge(meshes.back().getBounds());
+        budget_bytes -= std::min(budget_bytes, mesh.sizeInBytes());
+        ++data.next_mesh;
+    }
+    if (data.texture_arrays) {
+        packTextureArrays();
+        data.texture_arrays = false;
+    }
+    return true;
+}
+
+void Model::packTextureArrays() {
+    // normal and height maps aren't sampled from arrays, so they aren't copied
+    std::vector<Texture> textures;
+    for (const auto &texture : textures_loaded) {
+        if (Mesh::textureUnit(texture.role) >= 0) textures.push_back(texture);
+    }
+    std::unordered_map<unsigned int, TextureLayer> layers = ::packTextureArrays(textures);
+    if (layers.empty()) return;
+    for (auto &mesh : meshes) mesh.setTextureLayers(layers);
+
+    // the arrays are released with the model like its textures
+    TextureCache &cache = TextureCache::global();
+    for (const auto &[id, layer] : layers) {
+        if (std::find(texture_arrays.begin(), texture_arrays.end(), layer.array) ==
+            texture_arrays.end()) {
+            cache.adopt(layer.array);
+            texture_arrays.push_back(layer.array);
+        }
+    }
+    // nothing samples the packed 2D textures anymore, so the model drops its references on them
+    // instead of keeping every texel twice
+    auto packed = [&](const Texture &texture) { return layers.count(texture.id) != 0; };
+    for (const auto &texture : textures_loaded) {
+        if (packed(texture)) cache.release(texture.id);
+    }
+    textures_loaded.erase(std::remove_if(textures_loaded.begin(), textures_loaded.end(), packed),
+                          textures_loaded.end());
+    textures_loaded_index.clear();
+    for (size_t i = 0; i < textures_loaded.size(); ++i) {
+        textures_loaded_index.emplace(textures_loaded[i].path, i);
+    }
 }
 
 void Model::processNode(aiNode *node, const aiScene *scene,
-                        const std::vector<std::string> &mesh_names) {
+                        const std::vector<std::string> &mesh_names,
+                        std::vector<aiMesh *> &ai_meshes) {
     // process each mesh located at the current node
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         // the node object only contains indices to index the actual objects in the scene.
         // the scene contains all the data, node is just to keep stuff organized (like relations
         // between nodes).
         aiMesh *mesh = scene->mMeshes[node->mMeshes[i]];
-        if (mesh_names.empty() || std::find(mesh_names.begin(), mesh_names.end(),
-                                            mesh->mName.C_Str()) != mesh_names.end()) {
-            meshes.push_back(processMesh(mesh, scene));
+        if (isMeshRequested(mesh_names, mesh->mName.C_Str())) {
+            ai_meshes.push_back(mesh);
         }
     }
     // after we've processed all of the meshes (if any) we then recursively process each of the
     // children nodes
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene, mesh_names);
+        processNode(node->mChildren[i], scene, mesh_names, ai_meshes);
     }
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
+MeshData Model::processMesh(aiMesh *mesh, const aiScene *scene,
+                             const ModelLoadOptions &options) {
     // data to fill
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    MeshData data;
+    data.name = mesh->mName.C_Str();
+    data.has_bones = mesh->HasBones();
+    std::vector<Vertex> &vertices = data.vertices;
+    std::vector<unsigned int> &indices = data.indices;
+    vertices.reserve(mesh->mNumVertices);
+    indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 
     // walk through each of the mesh's vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
         Vertex vertex;
+        // no bone influences until the bones are read
+        for (int j = 0; j < MAX_BONE_INFLUENCE; ++j) {
+            vertex.m_BoneIDs[j] = -1;
+            vertex.m_Weights[j] = 0.0f;
+        }
         glm::vec3 vector;  // we declare a placeholder vector since assimp uses its own vector
                            // class that doesn't directly convert to glm's vec3 class so we
                            // transfer the data to this placeholder glm::vec3 first.
@@ -79,6 +548,10 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
             vec.x = mesh->mTextureCoords[0][i].x;
             vec.y = mesh->mTextureCoords[0][i].y;
             vertex.TexCoords = vec;
+        } else
+            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+        // ImportPreset::FastPreview doesn't compute tangents
+        if (mesh->HasTangentsAndBitangents()) {
             // tangent
             vector.x = mesh->mTangents[i].x;
             vector.y = mesh->mTangents[i].y;
@@ -89,8 +562,10 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
             vector.y = mesh->mBitangents[i].y;
             vector.z = mesh->mBitangents[i].z;
             vertex.Bitangent = vector;
-        } else
-            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+        } else {
+            vertex.Tangent = glm::vec3(0.0f);
+            vertex.Bitangent = glm::vec3(0.0f);
+        }
 
         vertices.push_back(vertex);
     }
@@ -110,16 +585,18 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     // specular: texture_specularN
     // normal: texture_normalN
 
-    std::multimap<std::string, Texture> textures;
-
-    for (auto &[ai_type, type] : ai_texture_type_to_type) {
-        std::vector<Texture> maps = loadMaterialTextures(ai_material, ai_type);
-        for (auto &texture : maps) {
-            textures.insert({type, texture});
+    // only the references are collected here, the textures are loaded when the mesh is uploaded
+    for (auto &[ai_type, role] : ai_texture_type_to_role) {
+        for (unsigned int i = 0; i < ai_material->GetTextureCount(ai_type); i++) {
+            aiString str;
+            if (ai_material->GetTexture(ai_type, i, &str) != AI_SUCCESS) {
+                throw std::runtime_error("fail getting texture from material");
+            }
+            data.textures.push_back(TextureRef{role, str.C_Str()});
         }
     }
 
-    Material material;
+    Material &material = data.material;
     aiColor3D color(0.f, 0.f, 0.f);
     material.name = ai_material->GetName().C_Str();
     if (AI_SUCCESS != ai_material->Get(AI_MATKEY_COLOR_DIFFUSE, color)) {
@@ -167,56 +644,53 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     //     throw std::runtime_error("fail getting AI_MATKEY_COLOR_TRANSPARENT");
     // }
 
-    std::cout << "mesh: " << mesh->mName.C_Str() << ": verts: " << mesh->mNumVertices << '\n';
-    glm::vec3 min(0), max(0);
-    for (size_t j = 0; j < mesh->mNumVertices; ++j) {
-        min.x = std::min(min.x, mesh->mVertices[j].x);
-        min.y = std::min(min.y, mesh->mVertices[j].y);
-        min.z = std::min(min.z, mesh->mVertices[j].z);
+    // meshes are processed concurrently, so the report is written out in one piece
+    std::ostringstream log;
+    log << "mesh: " << mesh->mName.C_Str() << ": verts: " << mesh->mNumVertices << '\n';
+    log << "material " << mesh->mMaterialIndex << ": " << ai_material->GetName().C_Str() << '\n';
+    finishMesh(data, options, log);
+    std::cout << log.str();
 
-        max.x = std::max(max.x, mesh->mVertices[j].x);
-        max.y = std::max(max.y, mesh->mVertices[j].y);
-        max.z = std::max(max.z, mesh->mVertices[j].z);
-    }
-    std::cout << "min: " << min.x << ' ' << min.y << ' ' << min.z << " max: " << max.x << ' '
-              << max.y << ' ' << max.z << '\n';
-
-    std::cout << "material " << mesh->mMaterialIndex << ": " << ai_material->GetName().C_Str()
-              << '\n';
-
-    // return a mesh object created from the extracted mesh data
-    return Mesh(mesh->mName.C_Str(), vertices, indices, textures, material);
+    // return the extracted mesh data, it is uploaded by the caller
+    return data;
 }
 
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type) {
-    std::string typeName = ai_texture_type_to_type.at(type);
-    std::vector<Texture> textures;
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
-        aiString str;
-        if (mat->GetTexture(type, i, &str) != AI_SUCCESS) {
-            throw std::runtime_error("fail getting texture from material");
-        }
-        // check if texture was loaded before and if so, continue to next iteration: skip
-        // loading a new texture
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-                textures.push_back(textures_loaded[j]);
-                skip = true;  // a texture with the same filepath has already been loaded,
-                              // continue to next one. (optimization)
-                break;
-            }
+bool Model::loadMaterialTextures(ModelData &data, const std::vector<TextureRef> &refs,
+                                 size_t &budget_bytes,
+                                 std::vector<Texture> &textures) {
+    TextureCache &cache = TextureCache::global();
+    for (const auto &ref : refs) {
+        // check if texture was loaded by this model before and if so, continue to next iteration
+        auto loaded = textures_loaded_index.find(ref.path);
+        if (loaded != textures_loaded_index.end()) {
+            // meshes may use the same file in different roles
+            textures.push_back(textures_loaded[loaded->second]);
+            textures.back().role = ref.role;
+            continue;
         }
-        if (!skip) {  // if texture hasn't been loaded already, load it
-            std::cout << typeName << " texture "
-                      << ": " << str.C_Str() << '\n';
-            Texture texture = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            textures.push_back(texture);
-            textures_loaded.push_back(
-                texture);  // store it as texture loaded for entire model, to ensure we won't
-                           // unnecessary load duplicate textures.
+
+        // otherwise share it with other models through the texture cache, which only uploads
+        // textures no model has loaded yet
+        std::string path = this->directory + '/' + ref.path;
+        Texture texture;
+        if (!cache.tryAcquire(path, {}, texture)) {
+            if (budget_bytes == 0) return false;
+            std::cout << textureRoleName(ref.role) << " texture "
+                      << ": " << ref.path << '\n';
+            // use the image decoded ahead of time if there is one
+            auto image = data.images.find(ref.path);
+            ImageData decoded =
+                image != data.images.end() ? std::move(image->second) : decodeImage(path);
+            if (image != data.images.end()) data.images.erase(image);
+
+            texture = cache.acquire(path, {}, &decoded);
+            budget_bytes -= std::min(budget_bytes, decoded.sizeInBytes());
         }
+        texture.path = ref.path;
+        texture.role = ref.role;
+        textures.push_back(texture);
+        textures_loaded_index.emplace(ref.path, textures_loaded.size());
+        textures_loaded.push_back(texture);
     }
-    return textures;
+    return true;
 }
\ No newline at end of file
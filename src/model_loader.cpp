@@ -0,0 +1,59 @@
+#include <learnopengl/model_loader.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+Model ModelHandle::takeModel() {
+    if (!isReady()) {
+        throw std::runtime_error("model is not loaded yet: " + file_path);
+    }
+    return std::move(model);
+}
+
+std::shared_ptr<ModelHandle> ModelLoader::load(const std::string &path,
+                                               const std::vector<std::string> &mesh_names,
+                                               const ModelLoadOptions &options) {
+    auto handle = std::make_shared<ModelHandle>();
+    handle->file_path = path;
+    handle->pending = ThreadPool::global().submit(
+        [path, mesh_names, options]() { return Model::loadData(path, mesh_names, options, true); });
+    handles.push_back(handle);
+    return handle;
+}
+
+std::vector<std::shared_ptr<ModelHandle>> ModelLoader::processUploads(size_t budget_bytes) {
+    std::vector<std::shared_ptr<ModelHandle>> finished;
+    for (auto &handle : handles) {
+        try {
+            if (handle->state == ModelHandle::State::Loading &&
+                handle->pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                handle->data = handle->pending.get();
+                handle->state = ModelHandle::State::Uploading;
+            }
+            if (handle->state == ModelHandle::State::Uploading && budget_bytes > 0 &&
+                handle->model.uploadStep(handle->data, budget_bytes)) {
+                // release the CPU side data (and the mapped cache) once it is on the GPU
+                handle->data = ModelData();
+                handle->state = ModelHandle::State::Ready;
+            }
+        } catch (const std::exception &e) {
+            std::cout << "ERROR::MODEL_LOADER:: " << handle->file_path << ": " << e.what() << '\n';
+            handle->error_message = e.what();
+            handle->data = ModelData();
+            handle->state = ModelHandle::State::Failed;
+        }
+        if (handle->isReady() || handle->isFailed()) {
+            finished.push_back(handle);
+        }
+    }
+
+    handles.erase(std::remove_if(handles.begin(), handles.end(),
+                                 [](const std::shared_ptr<ModelHandle> &handle) {
+                                     return handle->isReady() || handle->isFailed();
+                                 }),
+                  handles.end());
+    return finished;
+}
\ No newline at end of file
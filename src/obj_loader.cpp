@@ -0,0 +1,607 @@
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/obj_loader.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+// names Assimp gives to objects and materials the file doesn't name
+static const char *DEFAULT_OBJECT_NAME = "defaultobject";
+static const char *DEFAULT_MATERIAL_NAME = "DefaultMaterial";
+// the file is split into line ranges of about this size, which are parsed concurrently
+static const size_t OBJ_CHUNK_SIZE = 256 * 1024;
+
+enum ObjAttribute { OBJ_POSITION, OBJ_TEXCOORD, OBJ_NORMAL, OBJ_ATTRIBUTE_COUNT };
+static const size_t OBJ_ATTRIBUTE_SIZE[OBJ_ATTRIBUTE_COUNT] = {3, 2, 3};
+static const int64_t OBJ_NO_INDEX = -1;
+
+// position/texture coordinate/normal indices of a face corner, 0-based. Negative (relative)
+// indices of the file are first stored relative to the start of the chunk, with their bit set in
+// relative, and resolved once the element counts of the previous chunks are known.
+struct ObjCorner {
+    int64_t index[OBJ_ATTRIBUTE_COUNT];
+    uint8_t relative;
+};
+
+// a statement that changes which mesh the following faces belong to
+struct ObjStatement {
+    enum Type { Object, Material, Library } type;
+    // number of faces of the chunk before the statement
+    uint32_t face;
+    std::string_view name;
+};
+
+// parse result of a line range of the file
+struct ObjChunk {
+    const char *begin;
+    const char *end;
+    std::vector<float> elements[OBJ_ATTRIBUTE_COUNT];
+    std::vector<ObjCorner> corners;
+    // offset of the first corner of every face, plus the end of the last one
+    std::vector<uint32_t> faces;
+    std::vector<ObjStatement> statements;
+    // the line that failed to parse, if any
+    std::string_view error;
+};
+
+// faces [begin, end) of a chunk
+struct ObjFaceRange {
+    size_t chunk;
+    uint32_t begin;
+    uint32_t end;
+};
+
+struct ObjMesh {
+    std::string name;
+    std::string material;
+    std::vector<ObjFaceRange> ranges;
+};
+
+struct ObjMaterial {
+    Material material;
+    std::vector<std::pair<aiTextureType, std::string>> textures;
+};
+
+struct ObjVertexKey {
+    int64_t index[OBJ_ATTRIBUTE_COUNT];
+    bool operator==(const ObjVertexKey &other) const {
+        return std::memcmp(index, other.index, sizeof(index)) == 0;
+    }
+};
+
+struct ObjVertexKeyHash {
+    size_t operator()(const ObjVertexKey &key) const {
+        uint64_t hash = static_cast<uint64_t>(key.index[OBJ_POSITION]) * 0x9e3779b97f4a7c15ull;
+        hash ^= static_cast<uint64_t>(key.index[OBJ_TEXCOORD]) * 0xc2b2ae3d27d4eb4full;
+        hash ^= static_cast<uint64_t>(key.index[OBJ_NORMAL]) * 0x165667b19e3779f9ull;
+        return static_cast<size_t>(hash ^ (hash >> 29));
+    }
+};
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && isSpace(*p)) ++p;
+    return p;
+}
+
+static std::string_view token(const char *&p, const char *end) {
+    p = skipSpaces(p, end);
+    const char *begin = p;
+    while (p < end && !isSpace(*p)) ++p;
+    return std::string_view(begin, p - begin);
+}
+
+// the rest of the line without surrounding white space, names may contain spaces
+static std::string_view restOfLine(const char *p, const char *end) {
+    p = skipSpaces(p, end);
+    while (end > p && isSpace(end[-1])) --end;
+    return std::string_view(p, end - p);
+}
+
+// std::from_chars parses without locale or allocation and rounds correctly
+static bool parseFloat(const char *&p, const char *end, float &value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+') ++p;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc()) return false;
+    p = next;
+    return true;
+}
+
+static bool parseIndex(const char *&p, const char *end, size_t count, int64_t &index,
+                       bool &relative) {
+    int64_t value = 0;
+    auto [next, ec] = std::from_chars(p, end, value);
+    if (ec != std::errc() || value == 0) return false;
+    p = next;
+    relative = value < 0;
+    index = relative ? static_cast<int64_t>(count) + value : value - 1;
+    return true;
+}
+
+// v, v/vt, v//vn or v/vt/vn
+static bool parseCorner(const char *&p, const char *end, ObjChunk &chunk) {
+    ObjCorner corner{{OBJ_NO_INDEX, OBJ_NO_INDEX, OBJ_NO_INDEX}, 0};
+    for (int a = 0; a < OBJ_ATTRIBUTE_COUNT; ++a) {
+        if (a > 0) {
+            if (p == end || *p != '/') break;
+            ++p;
+            // an empty index, as in v//vn
+            if (p == end || *p == '/' || isSpace(*p)) continue;
+        }
+        size_t count = chunk.elements[a].size() / OBJ_ATTRIBUTE_SIZE[a];
+        bool relative = false;
+        if (!parseIndex(p, end, count, corner.index[a], relative)) return false;
+        if (relative) corner.relative |= 1 << a;
+    }
+    if (corner.index[OBJ_POSITION] == OBJ_NO_INDEX) return false;
+    chunk.corners.push_back(corner);
+    return true;
+}
+
+static bool parseLine(const char *p, const char *end, ObjChunk &chunk) {
+    std::string_view keyword = token(p, end);
+    if (keyword == "v" || keyword == "vn") {
+        // vertex colors after the position are ignored
+        auto &elements = chunk.elements[keyword == "v" ? OBJ_POSITION : OBJ_NORMAL];
+        float x, y, z;
+        if (!parseFloat(p, end, x) || !parseFloat(p, end, y) || !parseFloat(p, end, z)) {
+            return false;
+        }
+        elements.insert(elements.end(), {x, y, z});
+    } else if (keyword == "vt") {
+        // flipped like aiProcess_FlipUVs does, a missing v is 0
+        float u, v = 0.0f;
+        if (!parseFloat(p, end, u)) return false;
+        if (skipSpaces(p, end) != end && !parseFloat(p, end, v)) return false;
+        chunk.elements[OBJ_TEXCOORD].insert(chunk.elements[OBJ_TEXCOORD].end(), {u, 1.0f - v});
+    } else if (keyword == "f") {
+        size_t first = chunk.corners.size();
+        while ((p = skipSpaces(p, end)) < end) {
+            if (!parseCorner(p, end, chunk)) return false;
+        }
+        if (chunk.corners.size() - first < 3) return false;
+        chunk.faces.push_back(static_cast<uint32_t>(chunk.corners.size()));
+    } else if (keyword == "o" || keyword == "g") {
+        // Assimp maps groups to objects as well. A group without a name keeps the current one.
+        std::string_view name = restOfLine(p, end);
+        if (!name.empty()) {
+            uint32_t face = static_cast<uint32_t>(chunk.faces.size() - 1);
+            chunk.statements.push_back(ObjStatement{ObjStatement::Object, face, name});
+        }
+    } else if (keyword == "usemtl" || keyword == "mtllib") {
+        uint32_t face = static_cast<uint32_t>(chunk.faces.size() - 1);
+        auto type = keyword == "usemtl" ? ObjStatement::Material : ObjStatement::Library;
+        chunk.statements.push_back(ObjStatement{type, face, restOfLine(p, end)});
+    } else if (keyword == "l" || keyword == "p") {
+        // line and point primitives are left to Assimp
+        return false;
+    }
+    // comments, smoothing groups and everything else don't affect the meshes
+    return true;
+}
+
+static void parseChunk(ObjChunk &chunk) {
+    chunk.faces.push_back(0);
+    const char *line = chunk.begin;
+    while (line < chunk.end) {
+        const char *line_end =
+            static_cast<const char *>(std::memchr(line, '\n', chunk.end - line));
+        if (!line_end) line_end = chunk.end;
+        if (!parseLine(line, line_end, chunk)) {
+            chunk.error = std::string_view(line, line_end - line);
+            return;
+        }
+        line = line_end + 1;
+    }
+}
+
+static bool parseColor(const char *p, const char *end, glm::vec3 &color) {
+    // a single value is used for all channels
+    if (!parseFloat(p, end, color.r)) return false;
+    if (!parseFloat(p, end, color.g) || !parseFloat(p, end, color.b)) color.g = color.b = color.r;
+    return true;
+}
+
+// the file name of a texture map statement, skipping the options before it
+static std::string_view texturePath(const char *p, const char *end) {
+    static const std::pair<std::string_view, int> OPTIONS[] = {
+        {"-blendu", 1}, {"-blendv", 1}, {"-boost", 1}, {"-cc", 1},  {"-clamp", 1},
+        {"-imfchan", 1}, {"-texres", 1}, {"-bm", 1},   {"-type", 1}, {"-mm", 2},
+        {"-o", 3},      {"-s", 3},      {"-t", 3}};
+    for (;;) {
+        const char *option_end = p;
+        std::string_view option = token(option_end, end);
+        auto found = std::find_if(std::begin(OPTIONS), std::end(OPTIONS),
+                                  [&](const auto &known) { return known.first == option; });
+        if (found == std::end(OPTIONS)) return restOfLine(p, end);
+        p = option_end;
+        // -o, -s and -t take one to three numbers
+        for (int i = 0; i < found->second; ++i) {
+            const char *arg_end = p;
+            std::string_view arg = token(arg_end, end);
+            float value;
+            bool number = std::from_chars(arg.data(), arg.data() + arg.size(), value).ptr ==
+                          arg.data() + arg.size();
+            if (i > 0 && !number) break;
+            p = arg_end;
+        }
+    }
+}
+
+static ObjMaterial defaultMaterial(const std::string &name) {
+    ObjMaterial material;
+    material.material.name = name;
+    material.material.color_ambient = glm::vec3(0.0f);
+    material.material.color_diffuse = glm::vec3(0.6f);
+    material.material.color_specular = glm::vec3(0.0f);
+    return material;
+}
+
+static void loadMtl(const std::string &path,
+                    std::unordered_map<std::string, ObjMaterial> &materials) {
+    static const std::pair<std::string_view, aiTextureType> TEXTURE_TYPES[] = {
+        {"map_Kd", aiTextureType_DIFFUSE},    {"map_Ks", aiTextureType_SPECULAR},
+        {"map_Ka", aiTextureType_AMBIENT},    {"map_Ke", aiTextureType_EMISSIVE},
+        {"map_Ns", aiTextureType_SHININESS},  {"map_d", aiTextureType_OPACITY},
+        {"map_Bump", aiTextureType_HEIGHT},   {"map_bump", aiTextureType_HEIGHT},
+        {"bump", aiTextureType_HEIGHT},       {"map_Kn", aiTextureType_NORMALS},
+        {"norm", aiTextureType_NORMALS},      {"disp", aiTextureType_DISPLACEMENT}};
+
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        // like Assimp, the meshes keep their material names and get default values
+        std::cout << "ERROR::OBJ_LOADER:: can't read material library " << path << '\n';
+        return;
+    }
+    const char *line = reinterpret_cast<const char *>(file.data());
+    const char *end = line + file.size();
+    ObjMaterial *material = nullptr;
+    while (line < end) {
+        const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (!line_end) line_end = end;
+        const char *p = line;
+        std::string_view keyword = token(p, line_end);
+        if (keyword == "newmtl") {
+            std::string name(restOfLine(p, line_end));
+            material = &materials.insert_or_assign(name, defaultMaterial(name)).first->second;
+        } else if (material) {
+            Material &m = material->material;
+            float value;
+            if (keyword == "Ka") {
+                parseColor(p, line_end, m.color_ambient);
+            } else if (keyword == "Kd") {
+                parseColor(p, line_end, m.color_diffuse);
+            } else if (keyword == "Ks") {
+                parseColor(p, line_end, m.color_specular);
+            } else if (keyword == "Ns" && parseFloat(p, line_end, value)) {
+                m.shininess = value;
+            } else if (keyword == "Ni" && parseFloat(p, line_end, value)) {
+                m.refracti = value;
+            } else if (keyword == "d" && parseFloat(p, line_end, value)) {
+                m.dissolve = value;
+            } else if (keyword == "Tr" && parseFloat(p, line_end, value)) {
+                m.dissolve = 1.0f - value;
+            } else {
+                for (const auto &[map, type] : TEXTURE_TYPES) {
+                    if (keyword != map) continue;
+                    std::string_view texture = texturePath(p, line_end);
+                    if (!texture.empty()) material->textures.emplace_back(type, texture);
+                    break;
+                }
+            }
+        }
+        line = line_end + 1;
+    }
+}
+
+// the normal of every face for its vertices, like aiProcess_GenNormals. Only used for meshes
+// whose vertices aren't shared between faces.
+static void generateFlatNormals(MeshData &mesh) {
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        Vertex *v[3];
+        for (int k = 0; k < 3; ++k) v[k] = &mesh.vertices[mesh.indices[i + k]];
+        glm::vec3 normal = glm::cross(v[1]->Position - v[0]->Position,
+                                      v[2]->Position - v[0]->Position);
+        float length = glm::length(normal);
+        if (length > 0.0f) normal /= length;
+        for (int k = 0; k < 3; ++k) v[k]->Normal = normal;
+    }
+}
+
+static void generateNormals(MeshData &mesh, const std::vector<int64_t> &vertex_positions) {
+    // the normals of all faces around a position are averaged, like aiProcess_GenSmoothNormals
+    std::unordered_map<int64_t, glm::vec3> sums;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const glm::vec3 &p0 = mesh.vertices[mesh.indices[i]].Position;
+        const glm::vec3 &p1 = mesh.vertices[mesh.indices[i + 1]].Position;
+        const glm::vec3 &p2 = mesh.vertices[mesh.indices[i + 2]].Position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f) continue;
+        for (int k = 0; k < 3; ++k) {
+            sums[vertex_positions[mesh.indices[i + k]]] += normal / length;
+        }
+    }
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+        glm::vec3 sum = sums[vertex_positions[v]];
+        float length = glm::length(sum);
+        mesh.vertices[v].Normal = length > 0.0f ? sum / length : glm::vec3(0.0f);
+    }
+}
+
+// the tangents of vertex v are summed over the faces of all vertices with the same
+// vertex_shared[v], the vertex they would be joined into
+static void generateTangents(MeshData &mesh, const std::vector<unsigned int> &vertex_shared) {
+    // per face tangents along the texture u and v directions, summed per vertex like
+    // aiProcess_CalcTangentSpace and made orthogonal to the normal
+    std::vector<glm::vec3> tangents(mesh.vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangents(mesh.vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        const Vertex &v0 = mesh.vertices[mesh.indices[i]];
+        const Vertex &v1 = mesh.vertices[mesh.indices[i + 1]];
+        const Vertex &v2 = mesh.vertices[mesh.indices[i + 2]];
+        glm::vec3 e1 = v1.Position - v0.Position, e2 = v2.Position - v0.Position;
+        glm::vec2 d1 = v1.TexCoords - v0.TexCoords, d2 = v2.TexCoords - v0.TexCoords;
+        float det = d1.x * d2.y - d2.x * d1.y;
+        // faces without UV extent use the default directions
+        if (det == 0.0f) {
+            d1 = glm::vec2(0.0f, 1.0f);
+            d2 = glm::vec2(1.0f, 0.0f);
+            det = -1.0f;
+        }
+        float sign = det < 0.0f ? -1.0f : 1.0f;
+        glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) * sign;
+        glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) * sign;
+        for (int k = 0; k < 3; ++k) {
+            tangents[vertex_shared[mesh.indices[i + k]]] += tangent;
+            bitangents[vertex_shared[mesh.indices[i + k]]] += bitangent;
+        }
+    }
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+        Vertex &vertex = mesh.vertices[v];
+        const glm::vec3 &n = vertex.Normal;
+        const glm::vec3 &tangent = tangents[vertex_shared[v]];
+        const glm::vec3 &bitangent = bitangents[vertex_shared[v]];
+        glm::vec3 t = tangent - n * glm::dot(tangent, n);
+        glm::vec3 b = bitangent - n * glm::dot(bitangent, n);
+        if (glm::length(t) == 0.0f) {
+            t = glm::cross(n, std::abs(n.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0));
+        }
+        if (glm::length(t) > 0.0f) t = glm::normalize(t);
+        b = glm::length(b) > 0.0f ? glm::normalize(b) : glm::cross(n, t);
+        vertex.Tangent = t;
+        vertex.Bitangent = b;
+    }
+}
+
+// builds one mesh, corners with the same indices share a vertex if options.join_vertices is set
+static MeshData buildMesh(const ObjMesh &obj, const std::vector<ObjChunk> &chunks,
+                          const std::vector<float> (&elements)[OBJ_ATTRIBUTE_COUNT],
+                          const ObjMaterial &material, const ObjLoadOptions &options) {
+    MeshData mesh;
+    mesh.name = obj.name;
+    mesh.material = material.material;
+    if (mesh.material.shininess <= 0) mesh.material.shininess = 1;
+    // same order as the Assimp path, which walks ai_texture_type_to_role
+    for (auto &[ai_type, role] : ai_texture_type_to_role) {
+        for (const auto &[texture_type, path] : material.textures) {
+            if (texture_type == ai_type) mesh.textures.push_back(TextureRef{role, path});
+        }
+    }
+
+    size_t num_corners = 0;
+    for (const auto &range : obj.ranges) {
+        const auto &faces = chunks[range.chunk].faces;
+        num_corners += faces[range.end] - faces[range.begin];
+    }
+    std::unordered_map<ObjVertexKey, unsigned int, ObjVertexKeyHash> vertex_ids;
+    vertex_ids.reserve(num_corners);
+    std::vector<int64_t> vertex_positions;
+    // the first vertex of the corners with the same indices, the vertex itself when joining
+    std::vector<unsigned int> vertex_shared;
+    mesh.vertices.reserve(num_corners);
+    mesh.indices.reserve(num_corners * 3);
+
+    bool has_normals = false, has_texcoords = false;
+    std::vector<unsigned int> face;
+    for (const auto &range : obj.ranges) {
+        const ObjChunk &chunk = chunks[range.chunk];
+        for (uint32_t f = range.begin; f < range.end; ++f) {
+            face.clear();
+            for (uint32_t c = chunk.faces[f]; c < chunk.faces[f + 1]; ++c) {
+                const ObjCorner &corner = chunk.corners[c];
+                ObjVertexKey key;
+                std::memcpy(key.index, corner.index, sizeof(key.index));
+                auto id = static_cast<unsigned int>(mesh.vertices.size());
+                auto [it, inserted] = vertex_ids.try_emplace(key, id);
+                if (!inserted && options.join_vertices) {
+                    face.push_back(it->second);
+                    continue;
+                }
+                face.push_back(id);
+                vertex_shared.push_back(it->second);
+
+                Vertex vertex{};
+                for (int j = 0; j < MAX_BONE_INFLUENCE; ++j) vertex.m_BoneIDs[j] = -1;
+                const float *p = &elements[OBJ_POSITION][key.index[OBJ_POSITION] * 3];
+                vertex.Position = glm::vec3(p[0], p[1], p[2]);
+                if (key.index[OBJ_NORMAL] != OBJ_NO_INDEX) {
+                    const float *n = &elements[OBJ_NORMAL][key.index[OBJ_NORMAL] * 3];
+                    vertex.Normal = glm::vec3(n[0], n[1], n[2]);
+                    has_normals = true;
+                }
+                if (key.index[OBJ_TEXCOORD] != OBJ_NO_INDEX) {
+                    const float *t = &elements[OBJ_TEXCOORD][key.index[OBJ_TEXCOORD] * 2];
+                    vertex.TexCoords = glm::vec2(t[0], t[1]);
+                    has_texcoords = true;
+                }
+                mesh.vertices.push_back(vertex);
+                vertex_positions.push_back(key.index[OBJ_POSITION]);
+            }
+            // polygons are triangulated as fans, like aiProcess_Triangulate does for convex ones
+            for (size_t k = 1; k + 1 < face.size(); ++k) {
+                mesh.indices.insert(mesh.indices.end(), {face[0], face[k], face[k + 1]});
+            }
+        }
+    }
+
+    if (!has_normals) {
+        if (options.smooth_normals || options.join_vertices) {
+            generateNormals(mesh, vertex_positions);
+        } else {
+            generateFlatNormals(mesh);
+        }
+    }
+    if (has_texcoords && options.tangents) generateTangents(mesh, vertex_shared);
+    return mesh;
+}
+
+bool isObjFile(const std::string &path) {
+    if (path.size() < 4) return false;
+    std::string extension = path.substr(path.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".obj";
+}
+
+bool loadObj(const std::string &path, const std::vector<std::string> &mesh_names, bool parallel,
+             const ObjLoadOptions &options, std::vector<MeshData> &meshes) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cout << "ERROR::OBJ_LOADER:: can't read " << path << '\n';
+        return false;
+    }
+    auto forEach = [&](size_t count, const std::function<void(size_t)> &fn) {
+        if (parallel) {
+            ThreadPool::global().parallelFor(count, fn);
+        } else {
+            for (size_t i = 0; i < count; ++i) fn(i);
+        }
+    };
+
+    // split the file into line ranges and tokenize them concurrently
+    const char *data = reinterpret_cast<const char *>(file.data());
+    const char *data_end = data + file.size();
+    size_t num_chunks = parallel ? std::max<size_t>(1, file.size() / OBJ_CHUNK_SIZE) : 1;
+    std::vector<ObjChunk> chunks(num_chunks);
+    const char *begin = data;
+    for (size_t i = 0; i < num_chunks; ++i) {
+        const char *end = data + file.size() * (i + 1) / num_chunks;
+        if (end < begin) end = begin;
+        const char *line_end = static_cast<const char *>(std::memchr(end, '\n', data_end - end));
+        end = i + 1 == num_chunks || !line_end ? data_end : line_end + 1;
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        begin = end;
+    }
+    forEach(num_chunks, [&](size_t i) { parseChunk(chunks[i]); });
+    for (const auto &chunk : chunks) {
+        if (!chunk.error.empty()) {
+            std::cout << "ERROR::OBJ_LOADER:: unsupported line in " << path << ": "
+                      << chunk.error << '\n';
+            return false;
+        }
+    }
+
+    // resolve the relative indices now that the element counts of all chunks are known, and
+    // gather the elements into single arrays
+    std::vector<size_t> firsts[OBJ_ATTRIBUTE_COUNT];
+    std::vector<float> elements[OBJ_ATTRIBUTE_COUNT];
+    for (int a = 0; a < OBJ_ATTRIBUTE_COUNT; ++a) {
+        size_t total = 0;
+        for (const auto &chunk : chunks) {
+            firsts[a].push_back(total / OBJ_ATTRIBUTE_SIZE[a]);
+            total += chunk.elements[a].size();
+        }
+        elements[a].reserve(total);
+        for (auto &chunk : chunks) {
+            elements[a].insert(elements[a].end(), chunk.elements[a].begin(),
+                               chunk.elements[a].end());
+            std::vector<float>().swap(chunk.elements[a]);
+        }
+    }
+    std::vector<char> valid(num_chunks, 1);
+    forEach(num_chunks, [&](size_t i) {
+        for (auto &corner : chunks[i].corners) {
+            for (int a = 0; a < OBJ_ATTRIBUTE_COUNT; ++a) {
+                int64_t &index = corner.index[a];
+                if (index == OBJ_NO_INDEX && !(corner.relative & (1 << a))) continue;
+                if (corner.relative & (1 << a)) index += static_cast<int64_t>(firsts[a][i]);
+                size_t count = elements[a].size() / OBJ_ATTRIBUTE_SIZE[a];
+                if (index < 0 || static_cast<size_t>(index) >= count) valid[i] = 0;
+            }
+        }
+    });
+    if (std::find(valid.begin(), valid.end(), 0) != valid.end()) {
+        std::cout << "ERROR::OBJ_LOADER:: index out of range in " << path << '\n';
+        return false;
+    }
+
+    // split the faces into meshes: a new mesh starts with every object and whenever the
+    // material changes, meshes without faces are dropped
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    std::unordered_map<std::string, ObjMaterial> materials;
+    std::vector<ObjMesh> objs;
+    std::string object = DEFAULT_OBJECT_NAME;
+    std::string material = DEFAULT_MATERIAL_NAME;
+    bool new_mesh = true;
+    for (size_t c = 0; c < num_chunks; ++c) {
+        uint32_t face = 0;
+        auto addFaces = [&](uint32_t end) {
+            if (end == face) return;
+            if (new_mesh) objs.push_back(ObjMesh{object, material, {}});
+            new_mesh = false;
+            auto &ranges = objs.back().ranges;
+            if (!ranges.empty() && ranges.back().chunk == c && ranges.back().end == face) {
+                ranges.back().end = end;
+            } else {
+                ranges.push_back(ObjFaceRange{c, face, end});
+            }
+            face = end;
+        };
+        for (const auto &statement : chunks[c].statements) {
+            addFaces(statement.face);
+            if (statement.type == ObjStatement::Object) {
+                object = statement.name;
+                new_mesh = true;
+            } else if (statement.type == ObjStatement::Material) {
+                if (statement.name != material) new_mesh = true;
+                material = statement.name;
+            } else {
+                loadMtl(directory + std::string(statement.name), materials);
+            }
+        }
+        addFaces(static_cast<uint32_t>(chunks[c].faces.size() - 1));
+    }
+    objs.erase(std::remove_if(objs.begin(), objs.end(),
+                              [&](const ObjMesh &obj) {
+                                  return !mesh_names.empty() &&
+                                         std::find(mesh_names.begin(), mesh_names.end(),
+                                                   obj.name) == mesh_names.end();
+                              }),
+               objs.end());
+    // unknown materials keep their name and get default values
+    for (const auto &obj : objs) {
+        if (materials.count(obj.material) == 0) {
+            materials.emplace(obj.material, defaultMaterial(obj.material));
+        }
+    }
+
+    meshes.resize(objs.size());
+    forEach(objs.size(), [&](size_t i) {
+        meshes[i] =
+            buildMesh(objs[i], chunks, elements, materials.at(objs[i].material), options);
+    });
+    return true;
+}
\ No newline at end of file
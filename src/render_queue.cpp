@@ -0,0 +1,68 @@
+#include <learnopengl/render_queue.h>
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+static constexpr int DIGIT_BITS = 11;
+static constexpr int DIGITS = (64 + DIGIT_BITS - 1) / DIGIT_BITS;
+static constexpr size_t DIGIT_VALUES = size_t(1) << DIGIT_BITS;
+
+// the bits of a non negative float compare like its value. The top 24 of the 31 value bits keep
+// 16 bits of the mantissa, enough to order distances that differ by one part in 65536.
+static uint64_t depthBits(float depth) {
+    if (!(depth > 0.0f)) return 0;
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 7;
+}
+
+uint64_t RenderQueue::makeKey(Pass pass, uint32_t program, uint32_t material, uint32_t vao,
+                              float depth) {
+    uint64_t state = (uint64_t(program & 0x3FF) << 28) | (uint64_t(material & 0xFFFF) << 12) |
+                     uint64_t(vao & 0xFFF);
+    uint64_t key = uint64_t(pass) << 62;
+    if (pass == Pass::Transparent) {
+        // inverted, so the farthest draw comes first
+        return key | ((~depthBits(depth) & 0xFFFFFF) << 38) | state;
+    }
+    return key | (state << 24) | depthBits(depth);
+}
+
+void RenderQueue::sort() {
+    size_t count = packets.size();
+    if (count < 2) return;
+
+    // least significant digit first, 11 bits per pass so 64 bit keys take 6 passes. The counts
+    // of every digit are gathered in one read of the packets.
+    std::array<std::array<uint32_t, DIGIT_VALUES>, DIGITS> counts{};
+    for (const auto &packet : packets) {
+        for (int digit = 0; digit < DIGITS; ++digit) {
+            ++counts[digit][(packet.key >> (digit * DIGIT_BITS)) & (DIGIT_VALUES - 1)];
+        }
+    }
+
+    scratch.resize(count);
+    Packet *source = packets.data();
+    Packet *target = scratch.data();
+    for (int digit = 0; digit < DIGITS; ++digit) {
+        auto &offsets = counts[digit];
+        int shift = digit * DIGIT_BITS;
+        // a digit all keys share doesn't reorder anything, which skips most of the passes since
+        // the high fields of a frame take few values
+        if (offsets[(source[0].key >> shift) & (DIGIT_VALUES - 1)] == count) continue;
+
+        // the counts turn into the offsets of the values in target
+        uint32_t offset = 0;
+        for (auto &value_offset : offsets) {
+            uint32_t value_count = value_offset;
+            value_offset = offset;
+            offset += value_count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            target[offsets[(source[i].key >> shift) & (DIGIT_VALUES - 1)]++] = source[i];
+        }
+        std::swap(source, target);
+    }
+    if (source != packets.data()) packets.swap(scratch);
+}
\ No newline at end of file
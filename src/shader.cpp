@@ -1,5 +1,8 @@
+#include <learnopengl/gl_state.h>
 #include <learnopengl/shader.h>
 
+#include <algorithm>
+
 Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geometryPath) {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -79,6 +82,7 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
     if (!checkCompileErrors(ID, "PROGRAM")) {
         throw std::runtime_error("shader link error");
     }
+    collectUniforms();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
@@ -86,7 +90,7 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath, const char *geo
 }
 // activate the shader
 // ------------------------------------------------------------------------
-void Shader::use() const { glUseProgram(ID); }
+void Shader::use() const { GLState::global().useProgram(ID); }
 // utility uniform functions
 // ------------------------------------------------------------------------
 void Shader::setBool(const std::string &name, bool value) {
@@ -134,8 +138,62 @@ void Shader::setMat4(const std::string &name, const glm::mat4 &mat) {
     glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 
+Uniform Shader::uniform(uint32_t name_hash) const {
+    auto iter = std::lower_bound(
+        uniforms.begin(), uniforms.end(), name_hash,
+        [](const UniformEntry &entry, uint32_t hash) { return entry.hash < hash; });
+    if (iter == uniforms.end() || iter->hash != name_hash) return Uniform();
+    return Uniform{iter->location};
+}
+
+void Shader::setUniformBlockBinding(const char *block_name, unsigned int binding) const {
+    GLuint index = glGetUniformBlockIndex(ID, block_name);
+    if (index != GL_INVALID_INDEX) glUniformBlockBinding(ID, index, binding);
+}
+
+void Shader::collectUniforms() {
+    GLint count = 0, max_length = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+    std::vector<GLchar> buffer(std::max(max_length, 1));
+    auto add = [&](const std::string &name, GLint location) {
+        if (location >= 0) uniforms.push_back(UniformEntry{uniformHash(name), location});
+    };
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, i, static_cast<GLsizei>(buffer.size()), &length, &size, &type,
+                           buffer.data());
+        std::string name(buffer.data(), length);
+        // uniforms in blocks have no location
+        add(name, glGetUniformLocation(ID, name.c_str()));
+
+        // arrays of basic types are reported once as "name[0]"
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            std::string base = name.substr(0, name.size() - 3);
+            add(base, glGetUniformLocation(ID, base.c_str()));
+            for (GLint element = 1; element < size; ++element) {
+                std::string element_name = base + '[' + std::to_string(element) + ']';
+                add(element_name, glGetUniformLocation(ID, element_name.c_str()));
+            }
+        }
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(),
+              [](const UniformEntry &a, const UniformEntry &b) { return a.hash < b.hash; });
+    auto duplicate = std::adjacent_find(
+        uniforms.begin(), uniforms.end(),
+        [](const UniformEntry &a, const UniformEntry &b) { return a.hash == b.hash; });
+    if (duplicate != uniforms.end()) {
+        // two names of one program hash the same, rename one of them
+        std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION in program " << ID << std::endl;
+    }
+}
+
 GLint Shader::getUniformLocation(const std::string &name) {
-    auto ret = glGetUniformLocation(ID, name.c_str());
+    // the table has every active uniform, so the driver isn't asked
+    auto ret = uniform(name).location;
     // if (ret < 0) {
     //     GLenum err;
     //     while ((err = glGetError()) != GL_NO_ERROR) {
@@ -1,54 +1,115 @@
+#include <learnopengl/gl_state.h>
+#include <learnopengl/mapped_file.h>
 #include <learnopengl/texture.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/thread_pool.h>
 #include <stb_image.h>
 
+#include <chrono>
+#include <climits>
 #include <stdexcept>
 #include <tuple>
 
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-std::pair<unsigned int, unsigned int> loadTexturePair(const std::string& path,
-                                                      bool gammaCorrection) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+const char* textureRoleName(TextureRole role) {
+    switch (role) {
+        case TextureRole::Diffuse:
+            return "texture_diffuse";
+        case TextureRole::Specular:
+            return "texture_specular";
+        case TextureRole::Normal:
+            return "texture_normal";
+        case TextureRole::Height:
+            return "texture_height";
+        case TextureRole::Reflection:
+            return "texture_reflection";
+    }
+    return "unknown";
+}
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum internalFormat;
-        GLenum dataFormat;
-        if (nrComponents == 1) {
-            internalFormat = dataFormat = GL_RED;
-        } else if (nrComponents == 3) {
-            internalFormat = gammaCorrection ? GL_SRGB : GL_RGB;
-            dataFormat = GL_RGB;
-        } else if (nrComponents == 4) {
-            internalFormat = gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
-            dataFormat = GL_RGBA;
+bool parseTextureRole(std::string_view name, TextureRole& role) {
+    for (size_t i = 0; i < NUM_TEXTURE_ROLES; ++i) {
+        auto candidate = static_cast<TextureRole>(i);
+        if (name == textureRoleName(candidate)) {
+            role = candidate;
+            return true;
         }
+    }
+    return false;
+}
+
+void ImageDeleter::operator()(unsigned char* pixels) const { stbi_image_free(pixels); }
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat,
-                     GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                        dataFormat == GL_RGBA
-                            ? GL_CLAMP_TO_EDGE
-                            : GL_REPEAT);  // for this tutorial: use GL_CLAMP_TO_EDGE to prevent
-                                           // semi-transparent borders. Due to interpolation it
-                                           // takes texels from next repeat
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-                        dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        stbi_image_free(data);
+ImageData decodeImage(const std::string& path) {
+    // decoding from a mapping avoids stdio buffering and copying the compressed file
+    MappedFile file(path);
+    ImageData image;
+    if (file.isOpen() && file.size() <= INT_MAX) {
+        image.pixels.reset(stbi_load_from_memory(file.data(), static_cast<int>(file.size()),
+                                                 &image.width, &image.height,
+                                                 &image.num_components, 0));
+    }
+    if (!image.pixels) {
         throw std::runtime_error(std::string("Texture failed to load at path: ") + path);
     }
+    return image;
+}
+
+std::future<ImageData> decodeImageAsync(const std::string& path) {
+    return ThreadPool::global().submit([path]() { return decodeImage(path); });
+}
+
+std::vector<ImageData> decodeImages(const std::vector<std::string>& paths) {
+    std::vector<ImageData> images(paths.size());
+    ThreadPool::global().parallelFor(paths.size(),
+                                     [&](size_t i) { images[i] = decodeImage(paths[i]); });
+    return images;
+}
+
+std::pair<unsigned int, unsigned int> uploadTexture(const ImageData& image,
+                                                    const TextureParams& params) {
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    GLenum internalFormat = GL_RED;
+    GLenum dataFormat = GL_RED;
+    if (image.num_components == 1) {
+        internalFormat = dataFormat = GL_RED;
+    } else if (image.num_components == 3) {
+        internalFormat = params.srgb ? GL_SRGB : GL_RGB;
+        dataFormat = GL_RGB;
+    } else if (image.num_components == 4) {
+        internalFormat = params.srgb ? GL_SRGB_ALPHA : GL_RGBA;
+        dataFormat = GL_RGBA;
+    }
+
+    GLState::global().bindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, dataFormat,
+                 GL_UNSIGNED_BYTE, image.pixels.get());
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    GLint wrap = params.wrap;
+    if (wrap == 0) {
+        wrap = dataFormat == GL_RGBA
+                   ? GL_CLAMP_TO_EDGE
+                   : GL_REPEAT;  // for this tutorial: use GL_CLAMP_TO_EDGE to prevent
+                                 // semi-transparent borders. Due to interpolation it
+                                 // takes texels from next repeat
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.mag_filter);
+
+    return {textureID, image.num_components};
+}
 
-    return {textureID, nrComponents};
+// utility function for loading a 2D texture from file
+// ---------------------------------------------------
+std::pair<unsigned int, unsigned int> loadTexturePair(const std::string& path,
+                                                      bool gammaCorrection) {
+    TextureParams params;
+    params.srgb = gammaCorrection;
+    return uploadTexture(decodeImage(path), params);
 }
 
 unsigned int loadTexture(const std::string& path, bool gammaCorrection) {
@@ -65,22 +126,40 @@ unsigned int loadTexture(const std::string& path, bool gammaCorrection) {
 // -Z (back)
 // -------------------------------------------------------
 unsigned int loadCubemap(std::vector<std::string> faces) {
+    std::vector<std::future<ImageData>> decoded;
+    for (const auto& face : faces) {
+        decoded.push_back(decodeImageAsync(face));
+    }
+
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB,
-                         GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        } else {
-            stbi_image_free(data);
+    GLState::global().bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+
+    // upload the faces in the order they finish decoding, waiting only when none is ready
+    std::vector<unsigned int> remaining;
+    for (unsigned int i = 0; i < faces.size(); i++) remaining.push_back(i);
+    while (!remaining.empty()) {
+        size_t next = 0;
+        for (size_t j = 0; j < remaining.size(); ++j) {
+            if (decoded[remaining[j]].wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready) {
+                next = j;
+                break;
+            }
+        }
+        unsigned int i = remaining[next];
+        remaining.erase(remaining.begin() + next);
+
+        ImageData image;
+        try {
+            image = decoded[i].get();
+        } catch (const std::runtime_error&) {
+            GLState::global().deleteTextures(1, &textureID);
             throw std::runtime_error(std::string("Cubemap texture failed to load at path: ") +
                                      faces[i]);
         }
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, image.width, image.height, 0,
+                     GL_RGB, GL_UNSIGNED_BYTE, image.pixels.get());
     }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -94,8 +173,7 @@ unsigned int loadCubemap(std::vector<std::string> faces) {
 Texture TextureFromFile(std::string_view filename, const std::string& directory) {
     auto path = (directory + '/').append(filename);
 
-    Texture texture;
-    std::tie(texture.id, texture.num_components) = loadTexturePair(path.c_str());
+    Texture texture = TextureCache::global().acquire(path);
     texture.path = filename;
 
     return texture;
@@ -0,0 +1,82 @@
+#include <learnopengl/gl_state.h>
+#include <learnopengl/texture_array.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+// what the textures of one array have in common
+struct ArrayFormat {
+    GLint width = 0;
+    GLint height = 0;
+    GLint internal_format = 0;
+    GLint wrap_s = 0;
+    GLint wrap_t = 0;
+    GLint min_filter = 0;
+    GLint mag_filter = 0;
+
+    bool operator<(const ArrayFormat &other) const {
+        return std::tie(width, height, internal_format, wrap_s, wrap_t, min_filter, mag_filter) <
+               std::tie(other.width, other.height, other.internal_format, other.wrap_s,
+                        other.wrap_t, other.min_filter, other.mag_filter);
+    }
+};
+
+// the format of the bound GL_TEXTURE_2D
+static ArrayFormat boundFormat() {
+    ArrayFormat format;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &format.width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &format.height);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT,
+                             &format.internal_format);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &format.wrap_s);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &format.wrap_t);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &format.min_filter);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &format.mag_filter);
+    return format;
+}
+
+std::unordered_map<unsigned int, TextureLayer> packTextureArrays(
+    const std::vector<Texture> &textures) {
+    GLState &state = GLState::global();
+    std::map<ArrayFormat, std::vector<unsigned int>> groups;
+    for (const auto &texture : textures) {
+        state.bindTexture(GL_TEXTURE_2D, texture.id);
+        auto &ids = groups[boundFormat()];
+        if (std::find(ids.begin(), ids.end(), texture.id) == ids.end()) ids.push_back(texture.id);
+    }
+
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    std::unordered_map<unsigned int, TextureLayer> layers;
+    std::vector<unsigned char> texels;
+    for (const auto &[format, ids] : groups) {
+        // the texels are read and written as RGBA whatever the internal format is, GL converts
+        // them both ways
+        texels.resize(static_cast<size_t>(format.width) * format.height * 4);
+        // groups larger than GL_MAX_ARRAY_TEXTURE_LAYERS (at least 256) take several arrays
+        for (size_t first = 0; first + 1 < ids.size(); first += max_layers) {
+            auto num_layers =
+                static_cast<GLsizei>(std::min<size_t>(ids.size() - first, max_layers));
+            unsigned int array;
+            glGenTextures(1, &array);
+            state.bindTexture(GL_TEXTURE_2D_ARRAY, array);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format.internal_format, format.width,
+                         format.height, num_layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            for (GLsizei layer = 0; layer < num_layers; ++layer) {
+                unsigned int id = ids[first + layer];
+                state.bindTexture(GL_TEXTURE_2D, id);
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, format.width, format.height,
+                                1, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+                layers[id] = TextureLayer{array, layer};
+            }
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, format.wrap_s);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, format.wrap_t);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, format.min_filter);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, format.mag_filter);
+        }
+    }
+    return layers;
+}
\ No newline at end of file
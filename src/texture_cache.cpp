@@ -0,0 +1,160 @@
+#include <learnopengl/gl_state.h>
+#include <learnopengl/texture_cache.h>
+
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+TextureCache &TextureCache::global() {
+    static TextureCache cache;
+    return cache;
+}
+
+size_t TextureCache::KeyHash::operator()(const Key &key) const {
+    size_t hash = std::hash<std::string>()(key.path);
+    auto combine = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+    combine(key.params.srgb);
+    combine(static_cast<size_t>(key.params.wrap));
+    combine(static_cast<size_t>(key.params.min_filter));
+    combine(static_cast<size_t>(key.params.mag_filter));
+    return hash;
+}
+
+// FNV-1a over the image size and pixels
+static uint64_t hashImage(const ImageData &image) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const unsigned char *bytes, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    int header[3] = {image.width, image.height, image.num_components};
+    mix(reinterpret_cast<const unsigned char *>(header), sizeof(header));
+    mix(image.pixels.get(), image.sizeInBytes());
+    return hash;
+}
+
+TextureCache::Key TextureCache::makeKey(const std::string &path, const TextureParams &params) {
+    auto iter = canonical_paths.find(path);
+    if (iter == canonical_paths.end()) {
+        std::error_code ec;
+        auto canonical = std::filesystem::weakly_canonical(path, ec);
+        iter = canonical_paths.emplace(path, ec ? path : canonical.string()).first;
+    }
+    return Key{iter->second, params};
+}
+
+Texture TextureCache::addRef(Entry &entry) {
+    ++entry.refs;
+    return entry.texture;
+}
+
+bool TextureCache::contains(const std::string &path, const TextureParams &params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ids.count(makeKey(path, params)) != 0;
+}
+
+bool TextureCache::tryAcquire(const std::string &path, const TextureParams &params,
+                              Texture &texture) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = ids.find(makeKey(path, params));
+    if (iter == ids.end()) return false;
+    texture = addRef(entries.at(iter->second));
+    return true;
+}
+
+Texture TextureCache::acquire(const std::string &path, const TextureParams &params,
+                              const ImageData *decoded) {
+    Texture texture;
+    if (tryAcquire(path, params, texture)) return texture;
+
+    // decode and upload without holding the lock, only this (GL) thread inserts entries
+    ImageData image;
+    if (!decoded) {
+        image = decodeImage(path);
+        decoded = &image;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    Key key = makeKey(path, params);
+    uint64_t content_hash = 0;
+    if (content_dedup) {
+        lock.unlock();
+        content_hash = hashImage(*decoded);
+        lock.lock();
+        auto [first, last] = content_ids.equal_range(content_hash);
+        for (auto iter = first; iter != last; ++iter) {
+            Entry &entry = entries.at(iter->second);
+            if (entry.params == params) {
+                ids.emplace(std::move(key), iter->second);
+                return addRef(entry);
+            }
+        }
+    }
+    lock.unlock();
+
+    Entry entry;
+    std::tie(entry.texture.id, entry.texture.num_components) = uploadTexture(*decoded, params);
+    entry.texture.path = path;
+    entry.content_hash = content_hash;
+    entry.params = params;
+
+    lock.lock();
+    ids.emplace(std::move(key), entry.texture.id);
+    if (content_dedup) content_ids.emplace(content_hash, entry.texture.id);
+    return addRef(entries.emplace(entry.texture.id, entry).first->second);
+}
+
+void TextureCache::adopt(unsigned int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry &entry = entries[id];
+    entry.texture.id = id;
+    ++entry.refs;
+}
+
+void TextureCache::release(unsigned int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = entries.find(id);
+    if (iter != entries.end() && iter->second.refs > 0) {
+        --iter->second.refs;
+    }
+}
+
+size_t TextureCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t TextureCache::purge() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<unsigned int> unused;
+    for (const auto &[id, entry] : entries) {
+        if (entry.refs == 0) unused.push_back(id);
+    }
+    if (unused.empty()) return 0;
+
+    for (auto iter = ids.begin(); iter != ids.end();) {
+        if (entries.at(iter->second).refs == 0) {
+            iter = ids.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    for (auto iter = content_ids.begin(); iter != content_ids.end();) {
+        if (entries.at(iter->second).refs == 0) {
+            iter = content_ids.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    for (auto id : unused) {
+        entries.erase(id);
+    }
+    GLState::global().deleteTextures(static_cast<GLsizei>(unused.size()), unused.data());
+    return unused.size();
+}
\ No newline at end of file
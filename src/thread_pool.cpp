@@ -0,0 +1,100 @@
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::defaultThreadCount() {
+    // leave one core to the main thread which keeps rendering and uploading
+    size_t cores = std::thread::hardware_concurrency();
+    return std::max<size_t>(1, cores > 1 ? cores - 1 : 1);
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+    if (count == 0) return;
+
+    // the state is shared with the helper tasks, which may only get to run after the loop is
+    // finished when all workers are busy
+    struct State {
+        std::function<void(size_t)> fn;
+        std::atomic<size_t> next{0};
+        size_t done = 0;
+        size_t count = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<State>();
+    state->fn = fn;
+    state->count = count;
+
+    auto run = [](State &s) {
+        size_t i;
+        while ((i = s.next.fetch_add(1)) < s.count) {
+            std::exception_ptr error;
+            try {
+                s.fn(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (error && !s.error) s.error = error;
+            if (++s.done == s.count) s.finished.notify_all();
+        }
+    };
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        enqueue([state, run]() { run(*state); });
+    }
+    run(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->count; });
+    if (state->error) std::rethrow_exception(state->error);
+}
\ No newline at end of file